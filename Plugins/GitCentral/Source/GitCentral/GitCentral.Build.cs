@@ -33,7 +33,8 @@ public GitCentral(ReadOnlyTargetRules Target)
                 "UnrealEd",
                 "CoreUObject",
                 "Engine",
-                "Json"
+                "Json",
+                "DirectoryWatcher"
 			}
 		);
 	}
@@ -0,0 +1,290 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlCatFile.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlStats.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformTime.h"
+
+EGitCatFileResult::Type FGitCatFileBatch::GetObjectInfo(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InObjectName, FString& OutSha, FString& OutType, int64& OutSize)
+{
+	FGitScopedCommandTrace Trace(TEXT("cat-file --batch-check"), 1);
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(!EnsureRunning(CheckChannel, TEXT("--batch-check"), InPathToGitBinary, InRepositoryRoot))
+	{
+		return EGitCatFileResult::Failed;
+	}
+
+	StartQuery(CheckChannel);
+	const EGitCatFileResult::Type Result = Query(CheckChannel, InObjectName, OutSha, OutType, OutSize);
+	if(CheckChannel.bTimedOut)
+	{
+		Trace.SetTimedOut();
+	}
+	Trace.SetResult(0, GetTraceReturnCode(Result));
+	return Result;
+}
+
+EGitCatFileResult::Type FGitCatFileBatch::GetObjectContent(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InObjectName, TArray<uint8>& OutContent)
+{
+	FGitScopedCommandTrace Trace(TEXT("cat-file --batch"), 1);
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(!EnsureRunning(ContentChannel, TEXT("--batch"), InPathToGitBinary, InRepositoryRoot))
+	{
+		return EGitCatFileResult::Failed;
+	}
+
+	FString Sha;
+	FString Type;
+	int64 Size = 0;
+	StartQuery(ContentChannel);
+	const EGitCatFileResult::Type Result = Query(ContentChannel, InObjectName, Sha, Type, Size);
+	if(Result != EGitCatFileResult::Found)
+	{
+		if(ContentChannel.bTimedOut)
+		{
+			Trace.SetTimedOut();
+		}
+		Trace.SetResult(0, GetTraceReturnCode(Result));
+		return Result;
+	}
+
+	// TArray is indexed with int32, bigger objects cannot be read in memory
+	// Their content is still pending in the pipe, the process is restarted rather than drained
+	if(Size >= MAX_int32)
+	{
+		GITCENTRAL_LOG(TEXT("cat-file: %s is too large to be read in memory (%lld bytes)"), *InObjectName, Size);
+		Reset(ContentChannel);
+		return EGitCatFileResult::Failed;
+	}
+
+	// The content is followed by a line feed
+	OutContent.Reset();
+	TArray<uint8> Terminator;
+	if(!ReadBytes(ContentChannel, Size, OutContent) || !ReadBytes(ContentChannel, 1, Terminator) || Terminator[0] != '\n')
+	{
+		if(ContentChannel.bTimedOut)
+		{
+			Trace.SetTimedOut();
+		}
+		else
+		{
+			GITCENTRAL_ERROR(TEXT("cat-file: unexpected end of output while reading %s"), *InObjectName);
+		}
+		Reset(ContentChannel);
+		return EGitCatFileResult::Failed;
+	}
+
+	Trace.SetResult(OutContent.Num(), GetTraceReturnCode(EGitCatFileResult::Found));
+	return EGitCatFileResult::Found;
+}
+
+void FGitCatFileBatch::StartQuery(FChannel& InChannel)
+{
+	const double Timeout = FGitSourceControlModule::GetInstance().AccessSettings().GetCommandTimeout(TEXT("cat-file"));
+	InChannel.Deadline = Timeout > 0.0 ? FPlatformTime::Seconds() + Timeout : 0.0;
+	InChannel.bTimedOut = false;
+}
+
+bool FGitCatFileBatch::HasTimedOut(FChannel& InChannel)
+{
+	if(InChannel.Deadline > 0.0 && FPlatformTime::Seconds() > InChannel.Deadline)
+	{
+		GITCENTRAL_ERROR(TEXT("Timeout: git cat-file did not answer in time and is terminated (CommandTimeouts in the GitCentral.Settings section)"));
+		InChannel.bTimedOut = true;
+		return true;
+	}
+	return false;
+}
+
+int32 FGitCatFileBatch::GetTraceReturnCode(EGitCatFileResult::Type InResult)
+{
+	// Same as "git cat-file -e": 0 if the object exists, 1 if it does not
+	switch(InResult)
+	{
+	case EGitCatFileResult::Found:
+		return 0;
+	case EGitCatFileResult::Missing:
+		return 1;
+	default:
+		return -1;
+	}
+}
+
+void FGitCatFileBatch::Shutdown()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Reset(CheckChannel);
+	Reset(ContentChannel);
+}
+
+bool FGitCatFileBatch::EnsureRunning(FChannel& InChannel, const TCHAR* InMode, const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	if(InPathToGitBinary != PathToGitBinary || InRepositoryRoot != RepositoryRoot)
+	{
+		// Repository changed: both processes are now answering for the wrong repository
+		Reset(CheckChannel);
+		Reset(ContentChannel);
+		PathToGitBinary = InPathToGitBinary;
+		RepositoryRoot = InRepositoryRoot;
+	}
+
+	if(InChannel.Process.IsValid())
+	{
+		if(InChannel.Process.IsRunning())
+		{
+			return true;
+		}
+
+		GITCENTRAL_LOG(TEXT("cat-file %s exited with code %d, restarting"), InMode, InChannel.Process.GetReturnCode());
+		Reset(InChannel);
+	}
+
+	if(InPathToGitBinary.IsEmpty() || InRepositoryRoot.IsEmpty())
+	{
+		return false;
+	}
+
+	const FString Params = FString::Printf(TEXT("-C \"%s\" cat-file %s"), *InRepositoryRoot, InMode);
+	GITCENTRAL_VERBOSE(TEXT("CatFile: starting 'git cat-file %s'"), InMode);
+	return InChannel.Process.Launch(InPathToGitBinary, Params, true);
+}
+
+EGitCatFileResult::Type FGitCatFileBatch::Query(FChannel& InChannel, const FString& InObjectName, FString& OutSha, FString& OutType, int64& OutSize)
+{
+	// The protocol is line based
+	int32 NewLineIndex = INDEX_NONE;
+	if(InObjectName.FindChar(TEXT('\n'), NewLineIndex))
+	{
+		return EGitCatFileResult::Failed;
+	}
+	if(InObjectName.IsEmpty())
+	{
+		return EGitCatFileResult::Missing;
+	}
+
+	FString Header;
+	if(!InChannel.Process.WriteStdInLine(InObjectName) || !ReadLine(InChannel, Header))
+	{
+		GITCENTRAL_ERROR(TEXT("cat-file: no answer for %s"), *InObjectName);
+		Reset(InChannel);
+		return EGitCatFileResult::Failed;
+	}
+
+	// Example answers:
+	// 97a4e7626681895e073aaefd68b8ac087db81b0b commit 243
+	// origin/unknown missing
+	if(Header.EndsWith(TEXT(" missing"), ESearchCase::CaseSensitive) || Header.EndsWith(TEXT(" ambiguous"), ESearchCase::CaseSensitive))
+	{
+		return EGitCatFileResult::Missing;
+	}
+
+	TArray<FString> Tokens;
+	Header.ParseIntoArray(Tokens, TEXT(" "), true);
+	if(Tokens.Num() != 3)
+	{
+		GITCENTRAL_ERROR(TEXT("cat-file: unexpected answer '%s' for %s"), *Header, *InObjectName);
+		Reset(InChannel);
+		return EGitCatFileResult::Failed;
+	}
+
+	OutSha = MoveTemp(Tokens[0]);
+	OutType = MoveTemp(Tokens[1]);
+	OutSize = FCString::Atoi64(*Tokens[2]);
+	return EGitCatFileResult::Found;
+}
+
+bool FGitCatFileBatch::ReadLine(FChannel& InChannel, FString& OutLine)
+{
+	int32 IdleIterations = 0;
+	int32 SearchStart = 0;
+	for(;;)
+	{
+		for(int32 Index = SearchStart; Index < InChannel.Buffer.Num(); ++Index)
+		{
+			if(InChannel.Buffer[Index] == '\n')
+			{
+				FUTF8ToTCHAR Converted((const ANSICHAR*)InChannel.Buffer.GetData(), Index);
+				OutLine = FString(Converted.Length(), Converted.Get());
+				InChannel.Buffer.RemoveAt(0, Index + 1, false);
+				return true;
+			}
+		}
+		SearchStart = InChannel.Buffer.Num();
+
+		const bool bWasRunning = InChannel.Process.IsRunning();
+		if(InChannel.Process.ReadStdOut(InChannel.Buffer) == 0)
+		{
+			TArray<uint8> Errors;
+			if(InChannel.Process.ReadStdErr(Errors) > 0)
+			{
+				FUTF8ToTCHAR ErrorText((const ANSICHAR*)Errors.GetData(), Errors.Num());
+				GITCENTRAL_VERBOSE(TEXT("cat-file: %s"), *FString(ErrorText.Length(), ErrorText.Get()));
+			}
+
+			if(!bWasRunning)
+			{
+				// Everything the process wrote has been read
+				return false;
+			}
+			if(HasTimedOut(InChannel))
+			{
+				return false;
+			}
+			FGitProcess::WaitBackOff(IdleIterations);
+		}
+		else
+		{
+			IdleIterations = 0;
+		}
+	}
+}
+
+bool FGitCatFileBatch::ReadBytes(FChannel& InChannel, int64 InSize, TArray<uint8>& OutData)
+{
+	if(InSize < 0 || InSize > MAX_int32 - OutData.Num())
+	{
+		return false;
+	}
+	OutData.Reserve(OutData.Num() + (int32)InSize);
+
+	int64 Remaining = InSize;
+	int32 IdleIterations = 0;
+	for(;;)
+	{
+		const int32 Available = (int32)FMath::Min<int64>(Remaining, InChannel.Buffer.Num());
+		if(Available > 0)
+		{
+			OutData.Append(InChannel.Buffer.GetData(), Available);
+			InChannel.Buffer.RemoveAt(0, Available, false);
+			Remaining -= Available;
+		}
+
+		if(Remaining == 0)
+		{
+			return true;
+		}
+
+		const bool bWasRunning = InChannel.Process.IsRunning();
+		if(InChannel.Process.ReadStdOut(InChannel.Buffer) == 0)
+		{
+			if(!bWasRunning || HasTimedOut(InChannel))
+			{
+				return false;
+			}
+			FGitProcess::WaitBackOff(IdleIterations);
+		}
+		else
+		{
+			IdleIterations = 0;
+		}
+	}
+}
+
+void FGitCatFileBatch::Reset(FChannel& InChannel)
+{
+	InChannel.Process.Close();
+	InChannel.Buffer.Reset();
+}
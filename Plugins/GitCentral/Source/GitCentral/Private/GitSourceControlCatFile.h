@@ -0,0 +1,105 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "GitSourceControlProcess.h"
+
+namespace EGitCatFileResult
+{
+	enum Type
+	{
+		/** The object was found */
+		Found,
+		/** The object does not exist, or the name is ambiguous */
+		Missing,
+		/** The query could not be answered, the caller should fall back to a regular git command */
+		Failed,
+	};
+}
+
+/**
+ * Long lived "git cat-file --batch-check" and "git cat-file --batch" processes answering object queries over their standard input.
+ * Spawning git costs tens of milliseconds on Windows, most of it before any actual work is done,
+ * so object, size and rev lookups are sent to a process kept alive for the whole session instead.
+ *
+ * The processes are started on first use, and restarted if they die or if the binary or repository changes.
+ * A query that is not answered within the "cat-file" command timeout kills its process.
+ * Queries are serialized, this can be used from any thread.
+ */
+class FGitCatFileBatch
+{
+public:
+	/**
+	 * Resolve an object name to its object
+	 * @param	InPathToGitBinary	The path to the Git binary
+	 * @param	InRepositoryRoot	The Git repository to query
+	 * @param	InObjectName		Any name git understands: SHA, branch, "<commit>:<path>"...
+	 * @param	OutSha				The full SHA of the object
+	 * @param	OutType				The type of the object: commit, tree, blob or tag
+	 * @param	OutSize				The size of the object in bytes
+	 */
+	EGitCatFileResult::Type GetObjectInfo(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InObjectName, FString& OutSha, FString& OutType, int64& OutSize);
+
+	/**
+	 * Read the raw content of an object
+	 * @param	InPathToGitBinary	The path to the Git binary
+	 * @param	InRepositoryRoot	The Git repository to query
+	 * @param	InObjectName		Any name git understands: SHA, branch, "<commit>:<path>"...
+	 * @param	OutContent			The content of the object, as stored by git (no filters are applied)
+	 */
+	EGitCatFileResult::Type GetObjectContent(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InObjectName, TArray<uint8>& OutContent);
+
+	/** Stop the processes, they will be restarted on next use */
+	void Shutdown();
+
+private:
+	/** One cat-file process and its pending output */
+	struct FChannel
+	{
+		FGitProcess Process;
+
+		/** Bytes read from stdout and not consumed yet */
+		TArray<uint8> Buffer;
+
+		/** FPlatformTime::Seconds() after which the current query is abandoned, 0 if it may wait forever */
+		double Deadline = 0.0;
+
+		/** Whether the last read was abandoned because of the deadline */
+		bool bTimedOut = false;
+	};
+
+	/** Start the deadline of a query on this channel */
+	void StartQuery(FChannel& InChannel);
+
+	/** Whether the current query took too long, waiting for it must stop */
+	bool HasTimedOut(FChannel& InChannel);
+
+	/** Make sure the process of this channel is running for the requested repository */
+	bool EnsureRunning(FChannel& InChannel, const TCHAR* InMode, const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+	/** Send a query and parse the header line of the answer */
+	EGitCatFileResult::Type Query(FChannel& InChannel, const FString& InObjectName, FString& OutSha, FString& OutType, int64& OutSize);
+
+	/** Blocking read of a line from stdout, without the line terminator */
+	bool ReadLine(FChannel& InChannel, FString& OutLine);
+
+	/** Blocking read of an exact amount of bytes from stdout, fails if they do not fit in OutData */
+	bool ReadBytes(FChannel& InChannel, int64 InSize, TArray<uint8>& OutData);
+
+	/** Exit code reported to the command trace for a query result */
+	static int32 GetTraceReturnCode(EGitCatFileResult::Type InResult);
+
+	/** Restart the process on next use, used after any protocol error */
+	void Reset(FChannel& InChannel);
+
+	FCriticalSection CriticalSection;
+
+	/** Binary and repository the processes were started for */
+	FString PathToGitBinary;
+	FString RepositoryRoot;
+
+	FChannel CheckChannel;
+	FChannel ContentChannel;
+};
@@ -5,6 +5,90 @@
 #include "GitSourceControlProvider.h"
 #include "IGitSourceControlWorker.h"
 #include "SGitSourceControlSettings.h"
+#include "Misc/ScopeLock.h"
+
+bool FGitRefResolutionCache::FindCommitSha(const FString& InRef, FString& OutSha) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const FString* Sha = CommitShas.Find(InRef);
+	if(Sha)
+	{
+		OutSha = *Sha;
+	}
+	return Sha != nullptr;
+}
+
+void FGitRefResolutionCache::AddCommitSha(const FString& InRef, const FString& InSha)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	CommitShas.Add(InRef, InSha);
+}
+
+bool FGitRefResolutionCache::FindMergeBase(const FString& InCommit1, const FString& InCommit2, FString& OutMergeBase) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const FString* MergeBase = MergeBases.Find(MakeTuple(InCommit1, InCommit2));
+	if(!MergeBase)
+	{
+		//The merge base is symmetric
+		MergeBase = MergeBases.Find(MakeTuple(InCommit2, InCommit1));
+	}
+	if(MergeBase)
+	{
+		OutMergeBase = *MergeBase;
+	}
+	return MergeBase != nullptr;
+}
+
+void FGitRefResolutionCache::AddMergeBase(const FString& InCommit1, const FString& InCommit2, const FString& InMergeBase)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	MergeBases.Add(MakeTuple(InCommit1, InCommit2), InMergeBase);
+}
+
+bool FGitRefResolutionCache::FindIsAncestor(const FString& InAncestor, const FString& InCommit, bool& bOutIsAncestor) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const bool* bIsAncestor = Ancestors.Find(MakeTuple(InAncestor, InCommit));
+	if(bIsAncestor)
+	{
+		bOutIsAncestor = *bIsAncestor;
+	}
+	return bIsAncestor != nullptr;
+}
+
+void FGitRefResolutionCache::AddIsAncestor(const FString& InAncestor, const FString& InCommit, bool bIsAncestor)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Ancestors.Add(MakeTuple(InAncestor, InCommit), bIsAncestor);
+}
+
+void FGitRefResolutionCache::Invalidate()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	CommitShas.Reset();
+	MergeBases.Reset();
+	Ancestors.Reset();
+}
+
+/** Command executed by the current thread, so that helpers can reach its caches without passing it around */
+static thread_local FGitSourceControlCommand* CurrentCommand = nullptr;
+
+FGitSourceControlCommand* FGitSourceControlCommand::GetCurrent()
+{
+	return CurrentCommand;
+}
+
+FGitScopedCurrentCommand::FGitScopedCurrentCommand(FGitSourceControlCommand& InCommand)
+	: PreviousCommand(CurrentCommand)
+{
+	CurrentCommand = &InCommand;
+}
+
+FGitScopedCurrentCommand::~FGitScopedCurrentCommand()
+{
+	CurrentCommand = PreviousCommand;
+}
 
 FGitSourceControlCommand::FGitSourceControlCommand(const TSharedRef<class ISourceControlOperation, ESPMode::ThreadSafe>& InOperation, const TSharedRef<class IGitSourceControlWorker, ESPMode::ThreadSafe>& InWorker, const FSourceControlOperationComplete& InOperationCompleteDelegate)
 	: Operation(InOperation)
@@ -12,8 +96,14 @@ FGitSourceControlCommand::FGitSourceControlCommand(const TSharedRef<class ISourc
 	, OperationCompleteDelegate(InOperationCompleteDelegate)
 	, bExecuteProcessed(0)
 	, bCommandSuccessful(false)
+	, bCancelled(0)
+	, IgnoreCancelCount(0)
 	, bAutoDelete(true)
 	, Concurrency(EConcurrency::Synchronous)
+	, bCanCoalesce(false)
+	, bCoalesced(false)
+	, IssueSequence(0)
+	, StartSequence(0)
 {
 	// grab the providers settings here, so we don't access them once the worker thread is launched
 	check(IsInGameThread());
@@ -23,23 +113,62 @@ FGitSourceControlCommand::FGitSourceControlCommand(const TSharedRef<class ISourc
 	Branch = GitSourceControl.GetProvider().GetBranch();
 	Remote = GitSourceControl.GetProvider().GetRemote();
 	bUseLocking = GitSourceControl.AccessSettings().IsUsingLocking();
+	bAutoConfigureRepository = GitSourceControl.AccessSettings().IsAutoConfiguringRepository();
 }
 
 bool FGitSourceControlCommand::DoWork()
 {
-	bCommandSuccessful = Worker->Execute(*this);
+	TGuardValue<FGitSourceControlCommand*> CurrentCommandGuard(CurrentCommand, this);
+
+	FGitUpdateStatusCoalescer& Coalescer = FGitSourceControlModule::GetInstance().GetProvider().GetUpdateStatusCoalescer();
+	if(bCanCoalesce && !Coalescer.Start(*this))
+	{
+		//Reported by the command covering this one
+		bCommandSuccessful = true;
+		FPlatformAtomics::InterlockedExchange(&bExecuteProcessed, 1);
+		return bCommandSuccessful;
+	}
+
+	if(!IsCancelled())
+	{
+		bCommandSuccessful = Worker->Execute(*this);
+	}
+
+	if(bCanCoalesce)
+	{
+		Coalescer.Finish(*this);
+	}
+
+	//Note: a command cancelled too late to stop anything is still reported as successful
+	if(WasCancelled() && !bCommandSuccessful)
+	{
+		ErrorMessages.Add(FString::Printf(TEXT("%s was cancelled"), *Operation->GetName().ToString()));
+	}
 	FPlatformAtomics::InterlockedExchange(&bExecuteProcessed, 1);
 
 	return bCommandSuccessful;
 }
 
+void FGitSourceControlCommand::Cancel()
+{
+	FPlatformAtomics::InterlockedExchange(&bCancelled, 1);
+}
+
+bool FGitSourceControlCommand::IsCancelled() const
+{
+	return bCancelled != 0 && IgnoreCancelCount == 0;
+}
+
 void FGitSourceControlCommand::Abandon()
 {
+	if(bCanCoalesce)
+	{
+		FGitSourceControlModule::GetInstance().GetProvider().GetUpdateStatusCoalescer().Finish(*this);
+	}
 	FPlatformAtomics::InterlockedExchange(&bExecuteProcessed, 1);
 }
 
 void FGitSourceControlCommand::DoThreadedWork()
 {
-	Concurrency = EConcurrency::Asynchronous;
 	DoWork();
 }
@@ -4,6 +4,40 @@
 
 #include "ISourceControlProvider.h"
 #include "Misc/IQueuedWork.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Ref and merge-base resolutions memoized for the duration of a command.
+ * An operation resolving the same branches several times only asks git once.
+ * Cleared whenever the command runs a git command that may move refs (fetch, reset, commit, pull...).
+ */
+class FGitRefResolutionCache
+{
+public:
+	bool FindCommitSha(const FString& InRef, FString& OutSha) const;
+	void AddCommitSha(const FString& InRef, const FString& InSha);
+
+	bool FindMergeBase(const FString& InCommit1, const FString& InCommit2, FString& OutMergeBase) const;
+	void AddMergeBase(const FString& InCommit1, const FString& InCommit2, const FString& InMergeBase);
+
+	bool FindIsAncestor(const FString& InAncestor, const FString& InCommit, bool& bOutIsAncestor) const;
+	void AddIsAncestor(const FString& InAncestor, const FString& InCommit, bool bIsAncestor);
+
+	/** Forget everything, refs may have moved */
+	void Invalidate();
+
+private:
+	mutable FCriticalSection CriticalSection;
+
+	/** Ref or commit name to full SHA, empty if the ref does not exist */
+	TMap<FString, FString> CommitShas;
+
+	/** Pair of commits to their merge base */
+	TMap<TPair<FString, FString>, FString> MergeBases;
+
+	/** Pair of (ancestor, commit) to whether the first is an ancestor of the second */
+	TMap<TPair<FString, FString>, bool> Ancestors;
+};
 
 /**
  * Used to execute Git commands multi-threaded.
@@ -36,6 +70,18 @@ public:
 
 	inline FString GetRemoteBranch() { return Remote + "/" + Branch; }
 
+	/** @returns the command being executed by the calling thread, if any */
+	static FGitSourceControlCommand* GetCurrent();
+
+	/** Request cancellation from any thread: the running git processes are terminated and no new one is launched */
+	void Cancel();
+
+	/** @returns true if cancellation was requested and git processes must stop, false within a FGitScopedIgnoreCancel */
+	bool IsCancelled() const;
+
+	/** @returns true if cancellation was requested, even within a FGitScopedIgnoreCancel */
+	bool WasCancelled() const { return bCancelled != 0; }
+
 public:
 	/** Path to the Git binary */
 	FString PathToGitBinary;
@@ -52,6 +98,9 @@ public:
 	/** Whether we are using locking */
 	bool bUseLocking;
 
+	/** Whether Connect applies the recommended performance settings to the repository */
+	bool bAutoConfigureRepository;
+
 	/** Operation we want to perform - contains outward-facing parameters & results */
 	TSharedRef<class ISourceControlOperation, ESPMode::ThreadSafe> Operation;
 
@@ -67,10 +116,16 @@ public:
 	/**If true, the source control command succeeded*/
 	bool bCommandSuccessful;
 
+	/**If true, cancellation of this command was requested*/
+	volatile int32 bCancelled;
+
+	/**Number of FGitScopedIgnoreCancel alive on the worker thread*/
+	int32 IgnoreCancelCount;
+
 	/** If true, this command will be automatically cleaned up in Tick() */
 	bool bAutoDelete;
 
-	/** Whether we are running multi-treaded or not*/
+	/** Whether the game thread waits for this command, set when it is issued: every command runs on a thread of the scheduler */
 	EConcurrency::Type Concurrency;
 
 	/** Files to perform this operation on */
@@ -81,4 +136,56 @@ public:
 
 	/**Potential error message storage*/
 	TArray< FString > ErrorMessages;
-};
\ No newline at end of file
+
+	/** Refs and merge-bases resolved while executing this command */
+	FGitRefResolutionCache RefCache;
+
+	/** Whether this asynchronous UpdateStatus command may be merged with other ones by the FGitUpdateStatusCoalescer */
+	bool bCanCoalesce;
+
+	/** If true, this command did not run: its requests were handed to a running command covering them */
+	bool bCoalesced;
+
+	/** Order in which the command was issued and started, relative to the other coalescable commands */
+	uint64 IssueSequence;
+	uint64 StartSequence;
+
+	/** Operations and completion delegates of the commands merged into this one, reported with its result */
+	TArray<TPair<FSourceControlOperationRef, FSourceControlOperationComplete>> MergedRequests;
+};
+
+/**
+ * Let the git commands of a scope run even if the command was cancelled.
+ * Used by the workers to roll back partial changes (reset, rebase --abort, stash pop...) after a cancellation.
+ */
+class FGitScopedIgnoreCancel
+{
+public:
+	FGitScopedIgnoreCancel(FGitSourceControlCommand& InCommand)
+		: Command(InCommand)
+	{
+		++Command.IgnoreCancelCount;
+	}
+
+	~FGitScopedIgnoreCancel()
+	{
+		--Command.IgnoreCancelCount;
+	}
+
+private:
+	FGitSourceControlCommand& Command;
+};
+
+/**
+ * Make the calling thread execute on behalf of a command, for stages of a command running on other threads.
+ * They share the caches of the command and their git processes are terminated when it is cancelled.
+ */
+class FGitScopedCurrentCommand
+{
+public:
+	FGitScopedCurrentCommand(FGitSourceControlCommand& InCommand);
+	~FGitScopedCurrentCommand();
+
+private:
+	FGitSourceControlCommand* PreviousCommand;
+};
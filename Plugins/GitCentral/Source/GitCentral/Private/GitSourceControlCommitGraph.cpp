@@ -0,0 +1,675 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlCommitGraph.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlUtils.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace GitCommitGraphConstants
+{
+	/** Commits loaded from rev-list when the repository has no commit-graph */
+	static const int32 MaxRevListCommits = 100000;
+
+	/** Past this many new commits, the index is reloaded or git answers instead */
+	static const int32 MaxAddedCommits = 5000;
+
+	/** Size of a SHA-1, the only hash supported */
+	static const int32 HashSize = 20;
+
+	/** Parent values of the CDAT chunk */
+	static const uint32 NoParent = 0x70000000;
+	static const uint32 ExtraEdgesFlag = 0x80000000;
+}
+
+namespace
+{
+	using GitSourceControlUtils::ReadUInt32BigEndian;
+
+	uint64 ReadUInt64BigEndian(const uint8* InData)
+	{
+		return ((uint64)ReadUInt32BigEndian(InData) << 32) | (uint64)ReadUInt32BigEndian(InData + 4);
+	}
+
+	bool ParseSha(FStringView InHex, FSHAHash& OutHash)
+	{
+		if(InHex.Len() != 2 * GitCommitGraphConstants::HashSize)
+		{
+			return false;
+		}
+
+		for(int32 Index = 0; Index < GitCommitGraphConstants::HashSize; ++Index)
+		{
+			if(!FChar::IsHexDigit(InHex[2 * Index]) || !FChar::IsHexDigit(InHex[2 * Index + 1]))
+			{
+				return false;
+			}
+			OutHash.Hash[Index] = (uint8)((FParse::HexDigit(InHex[2 * Index]) << 4) | FParse::HexDigit(InHex[2 * Index + 1]));
+		}
+		return true;
+	}
+
+	FString ShaToString(const FSHAHash& InHash)
+	{
+		//Note: git SHAs are lower case
+		return InHash.ToString().ToLower();
+	}
+}
+
+bool FGitCommitGraph::AddCommits(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InCommits)
+{
+	bool bResult = true;
+	TArray<FSHAHash> Hashes;
+	Hashes.Reserve(InCommits.Num());
+	for(const FString& Commit : InCommits)
+	{
+		FSHAHash Hash;
+		if(ParseSha(Commit, Hash))
+		{
+			Hashes.Add(Hash);
+		}
+		else
+		{
+			bResult = false;
+		}
+	}
+
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		if(Index.RepositoryRoot == InRepositoryRoot && !Hashes.ContainsByPredicate([this](const FSHAHash& Hash) { return !Index.CommitIndices.Contains(Hash); }))
+		{
+			return bResult;
+		}
+	}
+
+	//Note: git runs without CriticalSection, queries are answered from the current index meanwhile
+	FScopeLock UpdateLock(&UpdateCriticalSection);
+
+	if(Index.RepositoryRoot != InRepositoryRoot)
+	{
+		Load(InPathToGitBinary, InRepositoryRoot, InCommits);
+	}
+
+	for(const FSHAHash& Hash : Hashes)
+	{
+		bool bTooFar = false;
+		if(!Index.CommitIndices.Contains(Hash) && !AddMissingCommit(InPathToGitBinary, InRepositoryRoot, Hash, bTooFar))
+		{
+			if(Index.bTruncated && bTooFar)
+			{
+				// Too far from the recent history that was loaded, load the history of these commits instead
+				Load(InPathToGitBinary, InRepositoryRoot, InCommits);
+				bResult &= Index.CommitIndices.Contains(Hash);
+			}
+			else
+			{
+				bResult = false;
+			}
+		}
+	}
+	return bResult;
+}
+
+bool FGitCommitGraph::IsAncestor(const FString& InRepositoryRoot, const FString& InAncestor, const FString& InCommit, bool& bOutIsAncestor) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(InRepositoryRoot != Index.RepositoryRoot)
+	{
+		return false;
+	}
+
+	const int32 Ancestor = Index.FindCommit(InAncestor);
+	const int32 Commit = Index.FindCommit(InCommit);
+	if(Ancestor == INDEX_NONE || Commit == INDEX_NONE)
+	{
+		return false;
+	}
+
+	//Note: the index only misses older commits, which cannot lead to an indexed commit
+	const uint32 AncestorGeneration = Index.Commits[Ancestor].Generation;
+	TArray<int32> Stack;
+	TSet<int32> Visited;
+	Stack.Add(Commit);
+	while(Stack.Num())
+	{
+		const int32 Current = Stack.Pop(false);
+		if(Current == Ancestor)
+		{
+			bOutIsAncestor = true;
+			return true;
+		}
+
+		// Only commits of a higher generation can lead to the ancestor
+		if(Index.Commits[Current].Generation <= AncestorGeneration)
+		{
+			continue;
+		}
+
+		for(int32 ParentIndex = 0; ParentIndex < Index.Commits[Current].NumParents; ++ParentIndex)
+		{
+			const int32 Parent = Index.Parents[Index.Commits[Current].FirstParent + ParentIndex];
+			if(Parent != INDEX_NONE && !Visited.Contains(Parent))
+			{
+				Visited.Add(Parent);
+				Stack.Add(Parent);
+			}
+		}
+	}
+
+	bOutIsAncestor = false;
+	return true;
+}
+
+bool FGitCommitGraph::FindMergeBase(const FString& InRepositoryRoot, const FString& InCommit1, const FString& InCommit2, FString& OutMergeBase) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(InRepositoryRoot != Index.RepositoryRoot)
+	{
+		return false;
+	}
+
+	const int32 Commit1 = Index.FindCommit(InCommit1);
+	const int32 Commit2 = Index.FindCommit(InCommit2);
+	if(Commit1 == INDEX_NONE || Commit2 == INDEX_NONE)
+	{
+		return false;
+	}
+
+	if(Commit1 == Commit2)
+	{
+		OutMergeBase = InCommit1;
+		return true;
+	}
+
+	// Same algorithm as git: paint the ancestors of each commit in generation order,
+	// the first commits reached from both sides are the merge-bases, their own ancestors are stale
+	enum EFlags : uint8
+	{
+		FromCommit1 = 1,
+		FromCommit2 = 2,
+		Stale = 4,
+		Result = 8,
+	};
+
+	// Flags of the painted commits, and how many times they are in the queue
+	struct FPaint
+	{
+		uint8 Flags = 0;
+		int32 NumQueued = 0;
+	};
+	TMap<int32, FPaint> Paint;
+
+	//Note: the walk ends when only stale commits are queued, counted as they are pushed, popped and painted stale instead of scanning the queue
+	const auto ByGeneration = [this](int32 A, int32 B) { return Index.Commits[A].Generation > Index.Commits[B].Generation; };
+	TArray<int32> Queue;
+	int32 NumNonStale = 0;
+	const auto Push = [&](int32 InCommit, uint8 InFlags)
+	{
+		FPaint& CommitPaint = Paint.FindOrAdd(InCommit);
+		if((InFlags & Stale) && !(CommitPaint.Flags & Stale))
+		{
+			NumNonStale -= CommitPaint.NumQueued;
+		}
+		CommitPaint.Flags |= InFlags;
+		CommitPaint.NumQueued++;
+		if(!(CommitPaint.Flags & Stale))
+		{
+			NumNonStale++;
+		}
+		Queue.HeapPush(InCommit, ByGeneration);
+	};
+	Push(Commit1, FromCommit1);
+	Push(Commit2, FromCommit2);
+
+	TArray<int32> Results;
+	while(NumNonStale > 0)
+	{
+		int32 Current;
+		Queue.HeapPop(Current, ByGeneration, false);
+
+		FPaint& CurrentPaint = Paint[Current];
+		CurrentPaint.NumQueued--;
+		if(!(CurrentPaint.Flags & Stale))
+		{
+			NumNonStale--;
+		}
+
+		uint8 PropagatedFlags = CurrentPaint.Flags & (FromCommit1 | FromCommit2 | Stale);
+		if(PropagatedFlags == (FromCommit1 | FromCommit2))
+		{
+			if(!(CurrentPaint.Flags & Result))
+			{
+				CurrentPaint.Flags |= Result;
+				Results.Add(Current);
+			}
+			PropagatedFlags |= Stale;
+		}
+
+		for(int32 ParentIndex = 0; ParentIndex < Index.Commits[Current].NumParents; ++ParentIndex)
+		{
+			const int32 Parent = Index.Parents[Index.Commits[Current].FirstParent + ParentIndex];
+			if(Parent == INDEX_NONE)
+			{
+				if(!(PropagatedFlags & Stale))
+				{
+					// The merge-base may be older than the indexed history
+					return false;
+				}
+				continue;
+			}
+
+			const FPaint* ParentPaint = Paint.Find(Parent);
+			if(!ParentPaint || (ParentPaint->Flags & PropagatedFlags) != PropagatedFlags)
+			{
+				Push(Parent, PropagatedFlags);
+			}
+		}
+	}
+
+	if(Results.Num() != 1)
+	{
+		// Unrelated histories, or criss-cross merges where git picks one of the candidates
+		return false;
+	}
+
+	OutMergeBase = ShaToString(Index.Commits[Results[0]].Id);
+	return true;
+}
+
+void FGitCommitGraph::Reset()
+{
+	FScopeLock UpdateLock(&UpdateCriticalSection);
+	FScopeLock ScopeLock(&CriticalSection);
+
+	Index = FIndex();
+}
+
+void FGitCommitGraph::Load(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InCommits)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Loaded aside, the current index keeps answering queries until it is replaced
+	FIndex NewIndex;
+	NewIndex.RepositoryRoot = InRepositoryRoot;
+
+	const FString GitDir = GitSourceControlUtils::GetGitDirectory(InPathToGitBinary, InRepositoryRoot);
+
+	bool bLoaded = false;
+	if(!GitDir.IsEmpty())
+	{
+		const FString CommitGraphFile = FPaths::Combine(GitDir, TEXT("objects/info/commit-graph"));
+		const FString ChainDirectory = FPaths::Combine(GitDir, TEXT("objects/info/commit-graphs"));
+		TArray<FString> ChainHashes;
+		if(FPaths::FileExists(CommitGraphFile))
+		{
+			bLoaded = LoadCommitGraphFile(CommitGraphFile, NewIndex);
+		}
+		else if(FFileHelper::LoadFileToStringArray(ChainHashes, *FPaths::Combine(ChainDirectory, TEXT("commit-graph-chain"))) && ChainHashes.Num())
+		{
+			// Split commit-graph, from the base file to the most recent one
+			bLoaded = true;
+			for(const FString& ChainHash : ChainHashes)
+			{
+				bLoaded = bLoaded && LoadCommitGraphFile(FPaths::Combine(ChainDirectory, FString::Printf(TEXT("graph-%s.graph"), *ChainHash.TrimStartAndEnd())), NewIndex);
+			}
+		}
+	}
+
+	if(!bLoaded)
+	{
+		NewIndex = FIndex();
+		NewIndex.RepositoryRoot = InRepositoryRoot;
+		NewIndex.bTruncated = true;
+		if(!LoadRevList(InPathToGitBinary, InRepositoryRoot, InCommits, NewIndex))
+		{
+			NewIndex.Commits.Reset();
+			NewIndex.Parents.Reset();
+			NewIndex.CommitIndices.Reset();
+		}
+	}
+
+	NewIndex.ComputeGenerations(0);
+
+	GITCENTRAL_VERBOSE(TEXT("CommitGraph: indexed %d commits from %s in %.1fms"), NewIndex.Commits.Num(), NewIndex.bTruncated ? TEXT("rev-list") : TEXT("commit-graph"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	FScopeLock ScopeLock(&CriticalSection);
+	Index = MoveTemp(NewIndex);
+}
+
+bool FGitCommitGraph::LoadCommitGraphFile(const FString& InFilename, FIndex& OutIndex)
+{
+	using namespace GitCommitGraphConstants;
+
+	TArray<uint8> Data;
+	if(!FFileHelper::LoadFileToArray(Data, *InFilename, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	// Header: signature, version, hash version, number of chunks, number of base files
+	if(Data.Num() < 8 || FMemory::Memcmp(Data.GetData(), "CGPH", 4) != 0 || Data[4] != 1 || Data[5] != 1)
+	{
+		GITCENTRAL_VERBOSE(TEXT("CommitGraph: unsupported commit-graph file %s"), *InFilename);
+		return false;
+	}
+
+	// Table of contents: chunk id and offset, terminated by a zero id
+	const int32 NumChunks = Data[6];
+	const int64 TableEnd = 8 + (int64)(NumChunks + 1) * 12;
+	if(Data.Num() < TableEnd)
+	{
+		return false;
+	}
+
+	const uint8* Fanout = nullptr;
+	const uint8* OidLookup = nullptr;
+	const uint8* CommitData = nullptr;
+	const uint8* ExtraEdges = nullptr;
+	int64 ExtraEdgesSize = 0;
+	for(int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+	{
+		const uint8* Entry = Data.GetData() + 8 + Chunk * 12;
+		const uint64 Offset = ReadUInt64BigEndian(Entry + 4);
+		const uint64 NextOffset = ReadUInt64BigEndian(Entry + 16);
+		if(Offset > NextOffset || NextOffset > (uint64)Data.Num())
+		{
+			return false;
+		}
+
+		const uint8* ChunkData = Data.GetData() + Offset;
+		if(FMemory::Memcmp(Entry, "OIDF", 4) == 0)
+		{
+			Fanout = NextOffset - Offset >= 256 * 4 ? ChunkData : nullptr;
+		}
+		else if(FMemory::Memcmp(Entry, "OIDL", 4) == 0)
+		{
+			OidLookup = ChunkData;
+		}
+		else if(FMemory::Memcmp(Entry, "CDAT", 4) == 0)
+		{
+			CommitData = ChunkData;
+		}
+		else if(FMemory::Memcmp(Entry, "EDGE", 4) == 0)
+		{
+			ExtraEdges = ChunkData;
+			ExtraEdgesSize = NextOffset - Offset;
+		}
+	}
+
+	if(!Fanout || !OidLookup || !CommitData)
+	{
+		return false;
+	}
+
+	const int32 NumCommits = (int32)ReadUInt32BigEndian(Fanout + 255 * 4);
+	if(OidLookup + (int64)NumCommits * HashSize > Data.GetData() + Data.Num() || CommitData + (int64)NumCommits * (HashSize + 16) > Data.GetData() + Data.Num())
+	{
+		return false;
+	}
+
+	// Parents are numbered across all the files of the chain
+	const int32 BaseCommits = OutIndex.Commits.Num();
+	const int32 BaseParents = OutIndex.Parents.Num();
+	OutIndex.Commits.Reserve(BaseCommits + NumCommits);
+	OutIndex.CommitIndices.Reserve(BaseCommits + NumCommits);
+	for(int32 CommitIndex = 0; CommitIndex < NumCommits; ++CommitIndex)
+	{
+		FCommit& Commit = OutIndex.Commits.AddDefaulted_GetRef();
+		FMemory::Memcpy(Commit.Id.Hash, OidLookup + CommitIndex * HashSize, HashSize);
+		OutIndex.CommitIndices.Add(Commit.Id, BaseCommits + CommitIndex);
+
+		// Tree id, first parent, second parent or extra edges, then the generation in the upper 30 bits and the commit date
+		const uint8* Entry = CommitData + CommitIndex * (HashSize + 16);
+		const uint32 FirstParent = ReadUInt32BigEndian(Entry + HashSize);
+		const uint32 SecondParent = ReadUInt32BigEndian(Entry + HashSize + 4);
+		Commit.Generation = ReadUInt32BigEndian(Entry + HashSize + 8) >> 2;
+		Commit.FirstParent = OutIndex.Parents.Num();
+
+		if(FirstParent != NoParent)
+		{
+			OutIndex.Parents.Add((int32)FirstParent);
+		}
+		if(SecondParent != NoParent)
+		{
+			if(SecondParent & ExtraEdgesFlag)
+			{
+				// Octopus merge: the remaining parents are listed in the extra edges, the last one is flagged
+				int64 Edge = SecondParent & ~ExtraEdgesFlag;
+				while(ExtraEdges && (Edge + 1) * 4 <= ExtraEdgesSize)
+				{
+					const uint32 Parent = ReadUInt32BigEndian(ExtraEdges + Edge * 4);
+					OutIndex.Parents.Add((int32)(Parent & ~ExtraEdgesFlag));
+					if(Parent & ExtraEdgesFlag)
+					{
+						break;
+					}
+					++Edge;
+				}
+			}
+			else
+			{
+				OutIndex.Parents.Add((int32)SecondParent);
+			}
+		}
+		Commit.NumParents = OutIndex.Parents.Num() - Commit.FirstParent;
+	}
+
+	// Parents must be in this file or in a base one
+	for(int32 ParentIndex = BaseParents; ParentIndex < OutIndex.Parents.Num(); ++ParentIndex)
+	{
+		if(OutIndex.Parents[ParentIndex] < 0 || OutIndex.Parents[ParentIndex] >= OutIndex.Commits.Num())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FGitCommitGraph::LoadRevList(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InCommits, FIndex& OutIndex)
+{
+	if(InCommits.Num() == 0)
+	{
+		return false;
+	}
+
+	//Note: in topological order, the most recent commits include all the descendants of any commit they contain,
+	// so the missing older commits can never lead to an indexed commit
+	TArray<TArray<FSHAHash>> CommitParents;
+	TArray<FString> Parameters = { TEXT("--parents"), TEXT("--topo-order"), TEXT("--ignore-missing"), FString::Printf(TEXT("--max-count=%d"), GitCommitGraphConstants::MaxRevListCommits) };
+	Parameters.Append(InCommits);
+	TArray<FString> ErrorMessages;
+	const bool bResult = GitSourceControlUtils::RunCommandStreamed(TEXT("rev-list"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(),
+		[&CommitParents](FStringView InLine)
+		{
+			// "<commit> <parent> <parent>..."
+			TArray<FSHAHash> Line;
+			while(InLine.Len() > 0)
+			{
+				int32 Separator = INDEX_NONE;
+				InLine.FindChar(TEXT(' '), Separator);
+				FSHAHash Hash;
+				if(ParseSha(Separator == INDEX_NONE ? InLine : InLine.Left(Separator), Hash))
+				{
+					Line.Add(Hash);
+				}
+				InLine = Separator == INDEX_NONE ? FStringView() : InLine.RightChop(Separator + 1);
+			}
+			if(Line.Num())
+			{
+				CommitParents.Add(MoveTemp(Line));
+			}
+		}, ErrorMessages);
+
+	if(!bResult)
+	{
+		GITCENTRAL_VERBOSE(TEXT("CommitGraph: could not list the history: %s"), *FString::Join(ErrorMessages, TEXT("\n")));
+		return false;
+	}
+
+	OutIndex.Commits.Reserve(CommitParents.Num());
+	OutIndex.CommitIndices.Reserve(CommitParents.Num());
+	for(const TArray<FSHAHash>& Line : CommitParents)
+	{
+		FCommit& Commit = OutIndex.Commits.AddDefaulted_GetRef();
+		Commit.Id = Line[0];
+		OutIndex.CommitIndices.Add(Commit.Id, OutIndex.Commits.Num() - 1);
+	}
+
+	for(int32 CommitIndex = 0; CommitIndex < CommitParents.Num(); ++CommitIndex)
+	{
+		FCommit& Commit = OutIndex.Commits[CommitIndex];
+		Commit.FirstParent = OutIndex.Parents.Num();
+		Commit.NumParents = CommitParents[CommitIndex].Num() - 1;
+		for(int32 ParentIndex = 1; ParentIndex < CommitParents[CommitIndex].Num(); ++ParentIndex)
+		{
+			const int32* Parent = OutIndex.CommitIndices.Find(CommitParents[CommitIndex][ParentIndex]);
+			OutIndex.Parents.Add(Parent ? *Parent : INDEX_NONE);
+		}
+	}
+
+	return true;
+}
+
+bool FGitCommitGraph::AddMissingCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FSHAHash& InCommit, bool& bOutTooFar)
+{
+	FGitCatFileBatch& CatFile = FGitSourceControlModule::GetInstance().GetProvider().GetCatFileBatch();
+
+	// Walk back from the commit until reaching indexed commits, new commits are only added if the walk completes
+	TMap<FSHAHash, TArray<FSHAHash>> NewCommits;
+	TArray<FSHAHash> Pending;
+	Pending.Add(InCommit);
+	while(Pending.Num())
+	{
+		const FSHAHash Current = Pending.Pop(false);
+		if(Index.CommitIndices.Contains(Current) || NewCommits.Contains(Current))
+		{
+			continue;
+		}
+
+		if(NewCommits.Num() >= GitCommitGraphConstants::MaxAddedCommits)
+		{
+			GITCENTRAL_VERBOSE(TEXT("CommitGraph: more than %d commits missing before %s"), GitCommitGraphConstants::MaxAddedCommits, *ShaToString(InCommit));
+			bOutTooFar = true;
+			return false;
+		}
+
+		TArray<uint8> Content;
+		if(CatFile.GetObjectContent(InPathToGitBinary, InRepositoryRoot, ShaToString(Current), Content) != EGitCatFileResult::Found)
+		{
+			return false;
+		}
+
+		// Commit headers: "tree <sha>", then one "parent <sha>" line per parent
+		TArray<FSHAHash>& CommitParents = NewCommits.Add(Current);
+		const FString Header = FString(FMath::Min(Content.Num(), 4096), (const ANSICHAR*)Content.GetData());
+		TArray<FString> Lines;
+		Header.ParseIntoArrayLines(Lines, false);
+		for(const FString& Line : Lines)
+		{
+			if(Line.IsEmpty())
+			{
+				break;
+			}
+
+			FSHAHash Parent;
+			if(Line.StartsWith(TEXT("parent ")) && ParseSha(FStringView(Line).RightChop(7), Parent))
+			{
+				CommitParents.Add(Parent);
+				Pending.Add(Parent);
+			}
+		}
+	}
+
+	FScopeLock ScopeLock(&CriticalSection);
+
+	const int32 FirstNewCommit = Index.Commits.Num();
+	for(const auto& It : NewCommits)
+	{
+		FCommit& Commit = Index.Commits.AddDefaulted_GetRef();
+		Commit.Id = It.Key;
+		Index.CommitIndices.Add(Commit.Id, Index.Commits.Num() - 1);
+	}
+
+	for(const auto& It : NewCommits)
+	{
+		FCommit& Commit = Index.Commits[Index.CommitIndices[It.Key]];
+		Commit.FirstParent = Index.Parents.Num();
+		Commit.NumParents = It.Value.Num();
+		for(const FSHAHash& Parent : It.Value)
+		{
+			Index.Parents.Add(Index.CommitIndices[Parent]);
+		}
+	}
+
+	Index.ComputeGenerations(FirstNewCommit);
+
+	GITCENTRAL_VERBOSE(TEXT("CommitGraph: added %d commits up to %s"), NewCommits.Num(), *ShaToString(InCommit));
+	return true;
+}
+
+void FGitCommitGraph::FIndex::ComputeGenerations(int32 InFirstCommit)
+{
+	// Depth first, a commit is done once all its parents are
+	TArray<int32> Stack;
+	for(int32 CommitIndex = InFirstCommit; CommitIndex < Commits.Num(); ++CommitIndex)
+	{
+		if(Commits[CommitIndex].Generation != 0)
+		{
+			continue;
+		}
+
+		Stack.Add(CommitIndex);
+		while(Stack.Num())
+		{
+			FCommit& Commit = Commits[Stack.Last()];
+			if(Commit.Generation != 0)
+			{
+				Stack.Pop(false);
+				continue;
+			}
+
+			uint32 Generation = 1;
+			bool bParentsDone = true;
+			for(int32 ParentIndex = 0; ParentIndex < Commit.NumParents; ++ParentIndex)
+			{
+				const int32 Parent = Parents[Commit.FirstParent + ParentIndex];
+				if(Parent == INDEX_NONE)
+				{
+					continue;
+				}
+
+				if(Commits[Parent].Generation == 0)
+				{
+					bParentsDone = false;
+					Stack.Add(Parent);
+				}
+				else
+				{
+					Generation = FMath::Max(Generation, Commits[Parent].Generation + 1);
+				}
+			}
+
+			if(bParentsDone)
+			{
+				Commit.Generation = Generation;
+				Stack.Pop(false);
+			}
+		}
+	}
+}
+
+int32 FGitCommitGraph::FIndex::FindCommit(const FString& InCommit) const
+{
+	FSHAHash Hash;
+	if(!ParseSha(InCommit, Hash))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32* FoundIndex = CommitIndices.Find(Hash);
+	return FoundIndex ? *FoundIndex : INDEX_NONE;
+}
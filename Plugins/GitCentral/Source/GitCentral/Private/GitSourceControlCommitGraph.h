@@ -0,0 +1,107 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/SecureHash.h"
+
+/**
+ * In-memory index of the commit history, answering ancestry and merge-base queries without spawning git.
+ * Loaded from the commit-graph files written by git when present, otherwise from rev-list over the most recent commits.
+ * Commits created or fetched since are added on demand by reading them from the persistent cat-file process.
+ *
+ * Walks are pruned with generation numbers: an ancestor always has a lower generation than its descendants.
+ * When the index cannot answer (unknown commit, history cut before the answer), queries fail and the caller should ask git.
+ * Thread safe.
+ */
+class FGitCommitGraph
+{
+public:
+	/**
+	 * Make sure the commits are in the index, loading it on first use and adding the commits created since
+	 * @param	InPathToGitBinary	The path to the Git binary
+	 * @param	InRepositoryRoot	The Git repository to index
+	 * @param	InCommits			Full SHAs of the commits to index
+	 * @returns true if all the commits are indexed
+	 */
+	bool AddCommits(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InCommits);
+
+	/**
+	 * Whether a commit is an ancestor of another one, or the same commit
+	 * @param	InAncestor			Full SHA of the supposed ancestor
+	 * @param	InCommit			Full SHA of the descendant
+	 * @param	bOutIsAncestor		The answer, only valid when true is returned
+	 * @returns false if the index cannot answer
+	 */
+	bool IsAncestor(const FString& InRepositoryRoot, const FString& InAncestor, const FString& InCommit, bool& bOutIsAncestor) const;
+
+	/**
+	 * Find the best common ancestor of two commits
+	 * @param	OutMergeBase	Full SHA of the merge-base, only valid when true is returned
+	 * @returns false if the index cannot answer, or if there are several best common ancestors (criss-cross merges)
+	 */
+	bool FindMergeBase(const FString& InRepositoryRoot, const FString& InCommit1, const FString& InCommit2, FString& OutMergeBase) const;
+
+	/** Forget the index, it will be loaded again on next use */
+	void Reset();
+
+private:
+	struct FCommit
+	{
+		FSHAHash Id;
+
+		/** 1 + the highest generation of the parents, 0 until computed */
+		uint32 Generation = 0;
+
+		/** Range of the parents in the Parents array, INDEX_NONE for parents outside of the index */
+		int32 FirstParent = 0;
+		int32 NumParents = 0;
+	};
+
+	/** The indexed history, replaced or extended as a whole under CriticalSection */
+	struct FIndex
+	{
+		/** Repository the index was loaded for, empty if not loaded */
+		FString RepositoryRoot;
+
+		/** Whether the index only contains the recent history, loaded from rev-list */
+		bool bTruncated = false;
+
+		TArray<FCommit> Commits;
+		TArray<int32> Parents;
+		TMap<FSHAHash, int32> CommitIndices;
+
+		/** Compute the generation of the commits from InFirstCommit which do not have one yet */
+		void ComputeGenerations(int32 InFirstCommit);
+
+		/** @returns the position of a commit in the index, INDEX_NONE if unknown */
+		int32 FindCommit(const FString& InCommit) const;
+	};
+
+	/** Load the commit-graph files, or the recent history when there are none, then replace the index. UpdateCriticalSection must be held */
+	void Load(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InCommits);
+
+	/** Load one commit-graph file, whose parents are numbered after the commits of the previous files of the chain */
+	static bool LoadCommitGraphFile(const FString& InFilename, FIndex& OutIndex);
+
+	/** Load the history of the commits with rev-list, up to MaxRevListCommits */
+	static bool LoadRevList(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InCommits, FIndex& OutIndex);
+
+	/**
+	 * Add a commit missing from the index and its missing ancestors, read from cat-file. UpdateCriticalSection must be held
+	 * @param	bOutTooFar	Set if more than MaxAddedCommits are missing, nothing is added then
+	 */
+	bool AddMissingCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FSHAHash& InCommit, bool& bOutTooFar);
+
+	/** Held by the queries and while the index is modified */
+	mutable FCriticalSection CriticalSection;
+
+	/**
+	 * Held for a whole update of the index, git commands included, so that queries are not blocked by them.
+	 * Only updates modify the index, so the updating thread can read it without CriticalSection. Taken before CriticalSection
+	 */
+	FCriticalSection UpdateCriticalSection;
+
+	FIndex Index;
+};
@@ -27,6 +27,22 @@ namespace Private_GitSourceControlCommands
 		TEXT("Prints the internal status of all known files"),
 		FConsoleCommandDelegate::CreateStatic(&GitSourceControlConsoleCommands::PrintStatusCache), ECVF_Cheat);
 
+	static FAutoConsoleCommand g_cmdPrintStats(TEXT("gitcentral.PrintStats"),
+		TEXT("Prints count, p50/p95/max durations of the git processes, per subcommand and per worker, and the command queue stats"),
+		FConsoleCommandDelegate::CreateStatic(&GitSourceControlConsoleCommands::PrintStats), ECVF_Cheat);
+
+	static FAutoConsoleCommand g_cmdResetStats(TEXT("gitcentral.ResetStats"),
+		TEXT("Clears the git process stats printed by gitcentral.PrintStats"),
+		FConsoleCommandDelegate::CreateStatic(&GitSourceControlConsoleCommands::ResetStats), ECVF_Cheat);
+
+	static FAutoConsoleCommand g_cmdFetch(TEXT("gitcentral.Fetch"),
+		TEXT("Fetches the remote branch in the background, and refreshes the states if it moved"),
+		FConsoleCommandDelegate::CreateStatic(&GitSourceControlConsoleCommands::Fetch), ECVF_Cheat);
+
+	static FAutoConsoleCommand g_cmdRequestFullStatusScan(TEXT("gitcentral.RequestFullStatusScan"),
+		TEXT("The next status refresh scans the whole repository instead of the paths changed on disk"),
+		FConsoleCommandDelegate::CreateStatic(&GitSourceControlConsoleCommands::RequestFullStatusScan), ECVF_Cheat);
+
 } // namespace Private_DatabaseCommands
 
 void GitSourceControlConsoleCommands::PrintStatus(const TArray<FString>& Args)
@@ -41,7 +57,7 @@ void GitSourceControlConsoleCommands::PrintStatus(const TArray<FString>& Args)
 
 	for (const auto& Arg : Args)
 	{
-		const auto State = Provider.GetStateInternal(Arg);
+		const auto State = Provider.GetStateStore().GetState(Arg);
 		State->DebugPrint();
 	}
 }
@@ -51,9 +67,31 @@ void GitSourceControlConsoleCommands::PrintStatusCache()
 	FGitSourceControlModule& Module = FGitSourceControlModule::GetInstance();
 	FGitSourceControlProvider& Provider = Module.GetProvider();
 
-	const auto& StateCache = Provider.GetAllStatesInternal();
-	for (const auto& State : StateCache)
+	Provider.GetStateStore().ForEachState([](const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>& State)
 	{
-		State.Value->DebugPrint();
-	}
+		State->DebugPrint();
+	});
+}
+
+void GitSourceControlConsoleCommands::PrintStats()
+{
+	FGitSourceControlModule::GetInstance().GetProvider().GetCommandStats().Print();
+	FGitSourceControlModule::GetInstance().GetProvider().GetScheduler().PrintStats();
+	FGitSourceControlModule::GetInstance().GetProvider().GetFetchScheduler().Print();
+}
+
+void GitSourceControlConsoleCommands::ResetStats()
+{
+	FGitSourceControlModule::GetInstance().GetProvider().GetCommandStats().Reset();
+	FGitSourceControlModule::GetInstance().GetProvider().GetScheduler().ResetStats();
+}
+
+void GitSourceControlConsoleCommands::RequestFullStatusScan()
+{
+	FGitSourceControlModule::GetInstance().GetProvider().GetDirtyPathTracker().RequestFullScan();
+}
+
+void GitSourceControlConsoleCommands::Fetch()
+{
+	FGitSourceControlModule::GetInstance().GetProvider().GetFetchScheduler().RequestFetch();
 }
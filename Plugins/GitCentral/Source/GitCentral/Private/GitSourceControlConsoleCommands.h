@@ -10,4 +10,8 @@ class GitSourceControlConsoleCommands
 public:
 	static void PrintStatus(const TArray<FString>& Args);
 	static void PrintStatusCache();
+	static void PrintStats();
+	static void ResetStats();
+	static void RequestFullStatusScan();
+	static void Fetch();
 };
@@ -0,0 +1,171 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlDirtyPaths.h"
+#include "GitSourceControlModule.h"
+#include "DirectoryWatcherModule.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformTime.h"
+
+namespace GitDirtyPathsConstants
+{
+	/** Past this many changed paths, one status of the whole repository is cheaper than a status of each path */
+	static const int32 MaxDirtyPaths = 2000;
+}
+
+void FGitDirtyPathTracker::Start(const FString& InRepositoryRoot)
+{
+	check(IsInGameThread());
+
+	if(InRepositoryRoot == RepositoryRoot && WatcherHandle.IsValid())
+	{
+		return;
+	}
+
+	Stop();
+
+	FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
+	if(DirectoryWatcher == nullptr)
+	{
+		return;
+	}
+
+	RepositoryRoot = InRepositoryRoot;
+
+	//Note: git status does not report ignored files, they would be cached as unchanged
+	IgnoredDirectories.Reset();
+	for(const FString& Directory : { FPaths::ProjectSavedDir(), FPaths::ProjectIntermediateDir(), FPaths::ProjectDir() / TEXT("DerivedDataCache/") })
+	{
+		FString FullDirectory = FPaths::ConvertRelativePathToFull(Directory);
+		FPaths::NormalizeDirectoryName(FullDirectory);
+		IgnoredDirectories.Add(FullDirectory / TEXT(""));
+	}
+	DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(RepositoryRoot, IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FGitDirtyPathTracker::OnDirectoryChanged),
+		WatcherHandle, IDirectoryWatcher::WatchOptions::IncludeDirectoryChanges);
+
+	GITCENTRAL_VERBOSE(TEXT("DirtyPaths: watching %s"), *RepositoryRoot);
+
+	FScopeLock ScopeLock(&CriticalSection);
+	bWatching = WatcherHandle.IsValid();
+	RequireFullScan();
+}
+
+void FGitDirtyPathTracker::Stop()
+{
+	check(IsInGameThread());
+
+	if(WatcherHandle.IsValid())
+	{
+		if(FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")))
+		{
+			if(IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule->Get())
+			{
+				DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(RepositoryRoot, WatcherHandle);
+			}
+		}
+		WatcherHandle.Reset();
+	}
+
+	RepositoryRoot.Reset();
+
+	FScopeLock ScopeLock(&CriticalSection);
+	bWatching = false;
+	RequireFullScan();
+}
+
+void FGitDirtyPathTracker::RequestFullScan()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	RequireFullScan();
+}
+
+void FGitDirtyPathTracker::RequireFullScan()
+{
+	//Note: the paths recorded so far are covered by the next full scan, which starts after now
+	bFullScanRequired = true;
+	FullScanRequiredEpoch = ScanEpoch;
+	DirtyPaths.Reset();
+}
+
+bool FGitDirtyPathTracker::ConsumeDirtyPaths(const FString& InHeadSha, const FString& InRemoteSha, TArray<FString>& OutDirtyPaths, uint32& OutScanEpoch)
+{
+	const float FullScanInterval = FGitSourceControlModule::GetInstance().AccessSettings().GetFullStatusScanInterval();
+
+	FScopeLock ScopeLock(&CriticalSection);
+
+	const bool bCommitsChanged = InHeadSha != ScannedHeadSha || InRemoteSha != ScannedRemoteSha;
+	//Note: an interval of 0 scans everything on every refresh
+	const bool bIntervalElapsed = FullScanInterval <= 0.f || FPlatformTime::Seconds() - LastFullScanTime > FullScanInterval;
+	if(!bWatching || bFullScanRequired || bCommitsChanged || bIntervalElapsed)
+	{
+		GITCENTRAL_VERBOSE(TEXT("DirtyPaths: full scan required (watching: %d, requested: %d, commits changed: %d, interval elapsed: %d)"),
+			bWatching, bFullScanRequired, bCommitsChanged, bIntervalElapsed);
+
+		// The full scan covers the paths recorded until now, the changes made while it runs are recorded in the next epoch
+		OutScanEpoch = ScanEpoch++;
+		return false;
+	}
+
+	DirtyPaths.GetKeys(OutDirtyPaths);
+	DirtyPaths.Reset();
+	return true;
+}
+
+void FGitDirtyPathTracker::OnFullScanCompleted(const FString& InHeadSha, const FString& InRemoteSha, uint32 InScanEpoch)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	ScannedHeadSha = InHeadSha;
+	ScannedRemoteSha = InRemoteSha;
+	LastFullScanTime = FPlatformTime::Seconds();
+
+	//Note: a full scan required while this one was running is still required
+	if(FullScanRequiredEpoch <= InScanEpoch)
+	{
+		bFullScanRequired = false;
+	}
+
+	for(auto It = DirtyPaths.CreateIterator(); It; ++It)
+	{
+		if(It.Value() <= InScanEpoch)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FGitDirtyPathTracker::OnDirectoryChanged(const TArray<FFileChangeData>& InFileChanges)
+{
+	const FString GitDirectory = RepositoryRoot / TEXT(".git/");
+
+	FScopeLock ScopeLock(&CriticalSection);
+
+	for(const FFileChangeData& FileChange : InFileChanges)
+	{
+		FString Path = FPaths::ConvertRelativePathToFull(FileChange.Filename);
+		FPaths::NormalizeFilename(Path);
+
+		if(Path.StartsWith(GitDirectory))
+		{
+			// The index, objects and remote refs are written by our own commands all the time and do not change what a full scan would report
+			// Moving the local branch (commit, reset, checkout, rebase made outside of the editor) changes the status of any file
+			const FString GitPath = Path.RightChop(GitDirectory.Len());
+			if(GitPath == TEXT("HEAD") || GitPath == TEXT("packed-refs") || GitPath.StartsWith(TEXT("refs/heads/")) || GitPath.StartsWith(TEXT("rebase-")) || GitPath == TEXT("MERGE_HEAD"))
+			{
+				RequireFullScan();
+			}
+			continue;
+		}
+
+		if(IgnoredDirectories.ContainsByPredicate([&Path](const FString& Directory) { return Path.StartsWith(Directory); }))
+		{
+			continue;
+		}
+
+		//Note: recorded even while a full scan is pending or running, it may have read the file before this change
+		DirtyPaths.Add(MoveTemp(Path), ScanEpoch);
+		if(DirtyPaths.Num() > GitDirtyPathsConstants::MaxDirtyPaths)
+		{
+			RequireFullScan();
+		}
+	}
+}
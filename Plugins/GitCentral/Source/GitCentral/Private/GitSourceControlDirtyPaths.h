@@ -0,0 +1,79 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "IDirectoryWatcher.h"
+
+/**
+ * Tracks the paths of the working copy changed since the last status refresh, using the directory watcher.
+ * A refresh of all files then only has to run git status on these paths instead of the whole repository.
+ *
+ * A full scan is still required when the tracked commits moved, when changes could not be tracked precisely,
+ * and every FullStatusScanInterval seconds in case the watcher missed something.
+ * Paths keep being recorded while a full scan is pending or running, tagged with the scan epoch they were recorded in:
+ * a completed scan only clears the paths recorded before it started, the changes made while it runs are refreshed next time.
+ * Started and stopped on the game thread, dirty paths can be consumed from any thread.
+ */
+class FGitDirtyPathTracker
+{
+public:
+	/** Start watching a repository, everything changed before is unknown so the next refresh is a full scan */
+	void Start(const FString& InRepositoryRoot);
+
+	/** Stop watching */
+	void Stop();
+
+	/** The next refresh will scan the whole repository */
+	void RequestFullScan();
+
+	/**
+	 * Take the paths changed since the last refresh
+	 * @param	InHeadSha			The commit of the local branch
+	 * @param	InRemoteSha			The commit of the remote branch
+	 * @param	OutDirtyPaths		Absolute paths of the changed files and directories
+	 * @param	OutScanEpoch		If a full scan is required, the epoch to give to OnFullScanCompleted
+	 * @returns false if a full scan is required instead, in which case the dirty paths are kept until the scan completes
+	 */
+	bool ConsumeDirtyPaths(const FString& InHeadSha, const FString& InRemoteSha, TArray<FString>& OutDirtyPaths, uint32& OutScanEpoch);
+
+	/**
+	 * Record a successful full scan, incremental refreshes are valid as long as the commits are the same
+	 * @param	InScanEpoch		The epoch returned by ConsumeDirtyPaths when the scan started
+	 */
+	void OnFullScanCompleted(const FString& InHeadSha, const FString& InRemoteSha, uint32 InScanEpoch);
+
+private:
+	/** Directory watcher callback, called on the game thread */
+	void OnDirectoryChanged(const TArray<FFileChangeData>& InFileChanges);
+
+	/** Require a full scan started after now, with CriticalSection held */
+	void RequireFullScan();
+
+	FCriticalSection CriticalSection;
+
+	FString RepositoryRoot;
+	FDelegateHandle WatcherHandle;
+
+	/** Directories written by the editor all the time, usually ignored by git */
+	TArray<FString> IgnoredDirectories;
+
+	/** Changed paths, with the epoch in which they last changed */
+	TMap<FString, uint32> DirtyPaths;
+
+	/** Incremented whenever a full scan starts, the paths recorded afterwards are not covered by it */
+	uint32 ScanEpoch = 0;
+
+	/** Whether a full scan is required, and the epoch in which it was last required: only a scan started later satisfies it */
+	bool bFullScanRequired = true;
+	uint32 FullScanRequiredEpoch = 0;
+
+	/** Whether the watcher is registered, read from worker threads */
+	bool bWatching = false;
+
+	/** Commits and time of the last full scan */
+	FString ScannedHeadSha;
+	FString ScannedRemoteSha;
+	double LastFullScanTime = 0.0;
+};
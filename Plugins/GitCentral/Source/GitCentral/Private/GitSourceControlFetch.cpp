@@ -0,0 +1,145 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlFetch.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlOperations.h"
+#include "SourceControlOperations.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformTime.h"
+
+void FGitFetchScheduler::RecordFetch(const FString& InRepositoryRoot, bool bInSucceeded, const FString& InRemoteSha, bool bInUpdatesAvailable)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	RepositoryRoot = InRepositoryRoot;
+	LastFetchSeconds = FPlatformTime::Seconds();
+	LastFetchTime = FDateTime::Now();
+	bLastFetchSucceeded = bInSucceeded;
+	if(bInSucceeded)
+	{
+		LastRemoteSha = InRemoteSha;
+		bUpdatesAvailable = bInUpdatesAvailable;
+	}
+	ScheduleNextFetch();
+}
+
+void FGitFetchScheduler::ClearUpdatesAvailable()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	bUpdatesAvailable = false;
+}
+
+bool FGitFetchScheduler::AreUpdatesAvailable() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return bUpdatesAvailable;
+}
+
+bool FGitFetchScheduler::IsStale(const FString& InRepositoryRoot, float InMaxAgeSeconds) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	//Note: a failed fetch counts too, a status update must not wait for the network timeout again while offline
+	return LastFetchSeconds < 0.0 || RepositoryRoot != InRepositoryRoot || FPlatformTime::Seconds() - LastFetchSeconds > InMaxAgeSeconds;
+}
+
+bool FGitFetchScheduler::WasLastFetchSuccessful() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return bLastFetchSucceeded;
+}
+
+bool FGitFetchScheduler::WasFetchedSince(const FString& InRepositoryRoot, double InSeconds, bool& bOutSucceeded) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	bOutSucceeded = bLastFetchSucceeded;
+	return LastFetchSeconds >= InSeconds && RepositoryRoot == InRepositoryRoot;
+}
+
+void FGitFetchScheduler::Print() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(LastFetchSeconds < 0.0)
+	{
+		GITCENTRAL_LOG(TEXT("Fetch: never fetched"));
+		return;
+	}
+
+	GITCENTRAL_LOG(TEXT("Fetch: last fetch %s at %s (%.0fs ago), remote at %s%s, next background fetch in %.0fs"),
+		bLastFetchSucceeded ? TEXT("succeeded") : TEXT("failed"), *LastFetchTime.ToString(), FPlatformTime::Seconds() - LastFetchSeconds,
+		LastRemoteSha.IsEmpty() ? TEXT("(unknown)") : *LastRemoteSha, bUpdatesAvailable ? TEXT(" with updates available") : TEXT(""),
+		FMath::Max(0.0, NextFetchSeconds - FPlatformTime::Seconds()));
+}
+
+void FGitFetchScheduler::RequestFetch()
+{
+	check(IsInGameThread());
+	bFetchRequested = true;
+}
+
+void FGitFetchScheduler::Tick(ISourceControlProvider& InProvider)
+{
+	check(IsInGameThread());
+	if(bFetchInProgress)
+	{
+		return;
+	}
+
+	if(!bFetchRequested)
+	{
+		const float Interval = FGitSourceControlModule::GetInstance().AccessSettings().GetFetchInterval();
+		FScopeLock ScopeLock(&CriticalSection);
+		if(Interval <= 0.f || FPlatformTime::Seconds() < NextFetchSeconds)
+		{
+			return;
+		}
+	}
+
+	bFetchRequested = false;
+	bFetchInProgress = true;
+	Provider = &InProvider;
+
+	const ECommandResult::Type Result = InProvider.Execute(ISourceControlOperation::Create<FGitFetch>(), TArray<FString>(), EConcurrency::Asynchronous,
+		FSourceControlOperationComplete::CreateRaw(this, &FGitFetchScheduler::OnFetchComplete));
+	if(Result != ECommandResult::Succeeded)
+	{
+		bFetchInProgress = false;
+		FScopeLock ScopeLock(&CriticalSection);
+		ScheduleNextFetch();
+	}
+}
+
+void FGitFetchScheduler::OnFetchComplete(const FSourceControlOperationRef& InOperation, ECommandResult::Type InResult)
+{
+	bFetchInProgress = false;
+
+	//Note: the remote states are computed against the remote branch, they are stale once it moved
+	const TSharedRef<FGitFetch, ESPMode::ThreadSafe> Operation = StaticCastSharedRef<FGitFetch>(InOperation);
+	if(InResult == ECommandResult::Succeeded && Operation->HasRemoteChanged() && Provider != nullptr)
+	{
+		GITCENTRAL_VERBOSE(TEXT("Fetch: the remote branch moved, refreshing the states"));
+		TSharedRef<FUpdateStatus, ESPMode::ThreadSafe> UpdateStatus = ISourceControlOperation::Create<FUpdateStatus>();
+		UpdateStatus->SetCheckingAllFiles(true);
+		Provider->Execute(UpdateStatus, TArray<FString>(), EConcurrency::Asynchronous);
+	}
+}
+
+void FGitFetchScheduler::Reset()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	RepositoryRoot.Reset();
+	LastFetchSeconds = -1.0;
+	LastRemoteSha.Reset();
+	bLastFetchSucceeded = false;
+	bUpdatesAvailable = false;
+	NextFetchSeconds = 0.0;
+	bFetchRequested = false;
+}
+
+void FGitFetchScheduler::ScheduleNextFetch()
+{
+	const FGitSourceControlSettings& Settings = FGitSourceControlModule::GetInstance().AccessSettings();
+	NextFetchSeconds = FPlatformTime::Seconds() + Settings.GetFetchInterval() + FMath::FRandRange(0.f, Settings.GetFetchIntervalJitter());
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "ISourceControlProvider.h"
+
+/**
+ * Keeps the remote branch fetched in the background, so that status updates do not have to fetch.
+ * Every fetch is recorded, whichever command ran it (connect, check-in, sync, status, background fetch), and pushes back
+ * the next background fetch, due FetchInterval seconds later plus a random jitter so that a team does not fetch in lockstep.
+ * Asynchronous status updates only fetch when the last fetch is older than FetchStalenessBudget seconds, synchronous ones always fetch.
+ * A fetch first probes the remote with ls-remote and is skipped when the remote branch did not move, the probe also tells
+ * whether the remote branch has commits the local branch does not have.
+ *
+ * The record can be read and updated from any thread, background fetches are issued from the game thread.
+ * Fetches run one at a time, whichever command runs them: commands reading the repository run concurrently, and concurrent
+ * fetches would fail on the lock files of the remote refs.
+ */
+class FGitFetchScheduler
+{
+public:
+	/**
+	 * Record a fetch of the remote branch
+	 * @param	InRemoteSha				The commit of the remote branch after the fetch
+	 * @param	bInUpdatesAvailable		Whether the remote branch has commits that are not in the local branch
+	 */
+	void RecordFetch(const FString& InRepositoryRoot, bool bInSucceeded, const FString& InRemoteSha, bool bInUpdatesAvailable);
+
+	/** Forget the updates available after pulling the remote branch */
+	void ClearUpdatesAvailable();
+
+	/** Whether the last fetch found commits to pull */
+	bool AreUpdatesAvailable() const;
+
+	/** Whether the last fetch of the repository, even failed, is older than InMaxAgeSeconds or there was none */
+	bool IsStale(const FString& InRepositoryRoot, float InMaxAgeSeconds) const;
+
+	/** Whether the last fetch reached the remote */
+	bool WasLastFetchSuccessful() const;
+
+	/**
+	 * Whether the repository was fetched after a time, by a fetch that ran while waiting for the fetch lock
+	 * @param	InSeconds		FPlatformTime::Seconds() before waiting
+	 * @param	bOutSucceeded	Whether that fetch reached the remote
+	 */
+	bool WasFetchedSince(const FString& InRepositoryRoot, double InSeconds, bool& bOutSucceeded) const;
+
+	/** Held by a command for the duration of its fetch, so that fetches do not run concurrently */
+	FCriticalSection& GetFetchCriticalSection() { return FetchCriticalSection; }
+
+	/** Print the time and remote commit of the last fetch to the log */
+	void Print() const;
+
+	/** Fetch on next Tick, even if the background fetch is disabled */
+	void RequestFetch();
+
+	/** Issue a background fetch when one is due. Game thread only */
+	void Tick(ISourceControlProvider& InProvider);
+
+	/** Forget the record, the next status update fetches */
+	void Reset();
+
+private:
+	/** Completion of a background fetch, refreshes the states if the remote branch moved */
+	void OnFetchComplete(const FSourceControlOperationRef& InOperation, ECommandResult::Type InResult);
+
+	/** Delay the next background fetch, with CriticalSection held */
+	void ScheduleNextFetch();
+
+	mutable FCriticalSection CriticalSection;
+
+	/** Serializes the fetches, held much longer than CriticalSection which protects the record */
+	FCriticalSection FetchCriticalSection;
+
+	/** Repository of the last fetch */
+	FString RepositoryRoot;
+
+	/** FPlatformTime::Seconds() of the last fetch, negative if none */
+	double LastFetchSeconds = -1.0;
+	FDateTime LastFetchTime;
+	FString LastRemoteSha;
+	bool bLastFetchSucceeded = false;
+	bool bUpdatesAvailable = false;
+
+	/** FPlatformTime::Seconds() at which the next background fetch is due */
+	double NextFetchSeconds = 0.0;
+
+	/** Game thread state of the background fetch */
+	bool bFetchRequested = false;
+	bool bFetchInProgress = false;
+
+	/** Provider the background fetches are issued to, to refresh the states after them */
+	ISourceControlProvider* Provider = nullptr;
+};
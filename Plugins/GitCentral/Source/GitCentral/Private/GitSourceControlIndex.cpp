@@ -0,0 +1,437 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlIndex.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlUtils.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace GitIndexConstants
+{
+	/** Size of a SHA-1, the only hash supported */
+	static const int32 HashSize = 20;
+
+	/** Fixed size part of an entry: stat data, mode, size, object id and flags */
+	static const int32 EntryHeaderSize = 62;
+
+	/** Flags of an entry */
+	static const uint16 ExtendedFlag = 0x4000;
+	static const uint16 StageMask = 0x3000;
+
+	/** Extended flags of an entry, version 3 and above */
+	static const uint16 SkipWorktreeFlag = 0x4000;
+	static const uint16 IntentToAddFlag = 0x2000;
+
+	/** Object type of regular files in the mode of an entry */
+	static const uint32 ObjectTypeMask = 0170000;
+	static const uint32 RegularFileType = 0100000;
+}
+
+namespace
+{
+	using GitSourceControlUtils::ReadUInt32BigEndian;
+
+	uint16 ReadUInt16BigEndian(const uint8* InData)
+	{
+		return (uint16)((InData[0] << 8) | InData[1]);
+	}
+
+	FString Utf8ToString(const uint8* InData, int32 InSize)
+	{
+		FUTF8ToTCHAR Converted((const ANSICHAR*)InData, InSize);
+		return FString(Converted.Length(), Converted.Get());
+	}
+
+	/** Length of a NUL terminated string, INDEX_NONE if not terminated before the end */
+	int64 FindNul(const uint8* InData, int64 InOffset, int64 InEnd)
+	{
+		for(int64 Index = InOffset; Index < InEnd; ++Index)
+		{
+			if(InData[Index] == 0)
+			{
+				return Index - InOffset;
+			}
+		}
+		return INDEX_NONE;
+	}
+}
+
+void FGitIndex::SplitUnchangedFiles(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutUnchangedFiles, TArray<FString>& OutOtherFiles)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(!Refresh(InPathToGitBinary, InRepositoryRoot))
+	{
+		OutOtherFiles.Append(InFiles);
+		return;
+	}
+
+	const FString CurrentHeadSha = GitSourceControlUtils::GetCommitShaForBranch(TEXT("HEAD"), InPathToGitBinary, InRepositoryRoot);
+	if(CurrentHeadSha != HeadSha)
+	{
+		HeadSha = CurrentHeadSha;
+		HeadTrees.Reset();
+	}
+
+	for(const FString& File : InFiles)
+	{
+		FString RelativeFile = File.StartsWith(InRepositoryRoot) ? File.RightChop(InRepositoryRoot.Len()) : FString();
+		RelativeFile.RemoveFromStart(TEXT("/"));
+
+		const FEntry* Entry = Entries.Find(RelativeFile);
+		if(Entry && Entry->bCanSkipStatus && !HeadSha.IsEmpty() && IsFileUnchanged(File, *Entry) && IsDirectoryUnchanged(InPathToGitBinary, InRepositoryRoot, RelativeFile))
+		{
+			OutUnchangedFiles.Add(File);
+		}
+		else
+		{
+			OutOtherFiles.Add(File);
+		}
+	}
+
+	GITCENTRAL_VERBOSE(TEXT("Index: %d unchanged files, %d to query"), OutUnchangedFiles.Num(), OutOtherFiles.Num());
+}
+
+void FGitIndex::Reset()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	RepositoryRoot.Reset();
+	IndexFile.Reset();
+	IndexModificationTime = FDateTime();
+	IndexSize = -1;
+	Entries.Empty();
+	ValidTrees.Empty();
+	HeadSha.Reset();
+	HeadTrees.Empty();
+}
+
+bool FGitIndex::Refresh(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	if(RepositoryRoot != InRepositoryRoot)
+	{
+		RepositoryRoot = InRepositoryRoot;
+		IndexFile.Reset();
+		IndexSize = -1;
+		Entries.Reset();
+		ValidTrees.Reset();
+
+		// Linked worktrees have their own index
+		const FString GitDir = GitSourceControlUtils::GetGitDirectory(InPathToGitBinary, InRepositoryRoot);
+		if(!GitDir.IsEmpty())
+		{
+			IndexFile = FPaths::Combine(GitDir, TEXT("index"));
+		}
+	}
+
+	if(IndexFile.IsEmpty())
+	{
+		return false;
+	}
+
+	const FFileStatData IndexStat = FPlatformFileManager::Get().GetPlatformFile().GetStatData(*IndexFile);
+	if(!IndexStat.bIsValid)
+	{
+		IndexSize = -1;
+		Entries.Reset();
+		ValidTrees.Reset();
+		return false;
+	}
+
+	if(IndexStat.ModificationTime == IndexModificationTime && IndexStat.FileSize == IndexSize)
+	{
+		return Entries.Num() > 0;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Note: git writes a new index and renames it, so the content cannot change while being read
+	IndexModificationTime = IndexStat.ModificationTime;
+	IndexSize = IndexStat.FileSize;
+	Entries.Reset();
+	ValidTrees.Reset();
+
+	TArray<uint8> Data;
+	if(!FFileHelper::LoadFileToArray(Data, *IndexFile, FILEREAD_Silent) || !Parse(Data))
+	{
+		GITCENTRAL_VERBOSE(TEXT("Index: could not parse %s, git status will be used"), *IndexFile);
+		Entries.Reset();
+		ValidTrees.Reset();
+		return false;
+	}
+
+	GITCENTRAL_VERBOSE(TEXT("Index: parsed %d entries and %d valid trees in %.1fms"), Entries.Num(), ValidTrees.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	return Entries.Num() > 0;
+}
+
+bool FGitIndex::Parse(const TArray<uint8>& InData)
+{
+	using namespace GitIndexConstants;
+
+	// Header: signature, version and number of entries, the file ends with a checksum
+	const uint8* Data = InData.GetData();
+	const int64 End = (int64)InData.Num() - HashSize;
+	uint32 Version = 0;
+	uint32 NumEntries = 0;
+	if(!GitSourceControlUtils::ParseIndexHeader(Data, End, Version, NumEntries) || Version < 2 || Version > 4)
+	{
+		return false;
+	}
+
+	Entries.Reserve(NumEntries);
+
+	int64 Offset = 12;
+	TArray<uint8> Path;
+	for(uint32 Index = 0; Index < NumEntries; ++Index)
+	{
+		if(Offset + EntryHeaderSize > End)
+		{
+			return false;
+		}
+
+		const uint8* EntryData = Data + Offset;
+		const uint32 Mode = ReadUInt32BigEndian(EntryData + 24);
+		const uint16 Flags = ReadUInt16BigEndian(EntryData + 60);
+		uint16 ExtendedFlags = 0;
+		int64 PathOffset = Offset + EntryHeaderSize;
+		if(Flags & ExtendedFlag)
+		{
+			if(Version < 3 || PathOffset + 2 > End)
+			{
+				return false;
+			}
+			ExtendedFlags = ReadUInt16BigEndian(Data + PathOffset);
+			PathOffset += 2;
+		}
+
+		if(Version >= 4)
+		{
+			// The path is prefix compressed: number of bytes to remove from the previous path, then the suffix to append
+			int64 RemovedBytes = 0;
+			uint8 Byte = 0;
+			int32 VarIntBytes = 0;
+			do
+			{
+				if(PathOffset >= End || ++VarIntBytes > 8)
+				{
+					return false;
+				}
+				Byte = Data[PathOffset++];
+				RemovedBytes = VarIntBytes > 1 ? ((RemovedBytes + 1) << 7) | (Byte & 0x7f) : (Byte & 0x7f);
+			}
+			while(Byte & 0x80);
+
+			const int64 SuffixLength = FindNul(Data, PathOffset, End);
+			if(RemovedBytes > Path.Num() || SuffixLength == INDEX_NONE)
+			{
+				return false;
+			}
+			Path.SetNum(Path.Num() - (int32)RemovedBytes, false);
+			Path.Append(Data + PathOffset, (int32)SuffixLength);
+			Offset = PathOffset + SuffixLength + 1;
+		}
+		else
+		{
+			// The path is NUL terminated and padded to a multiple of 8 bytes
+			const int64 PathLength = FindNul(Data, PathOffset, End);
+			if(PathLength == INDEX_NONE)
+			{
+				return false;
+			}
+			Path.Reset();
+			Path.Append(Data + PathOffset, (int32)PathLength);
+			Offset += (PathOffset - Offset + PathLength + 8) & ~7;
+		}
+
+		const FString RelativePath = Utf8ToString(Path.GetData(), Path.Num());
+		if(FEntry* ExistingEntry = Entries.Find(RelativePath))
+		{
+			// Several stages of a conflicted file
+			ExistingEntry->bCanSkipStatus = false;
+			continue;
+		}
+
+		FEntry& Entry = Entries.Add(RelativePath);
+		Entry.ModificationSeconds = ReadUInt32BigEndian(EntryData + 8);
+		Entry.ModificationNanoseconds = ReadUInt32BigEndian(EntryData + 12);
+		Entry.Size = ReadUInt32BigEndian(EntryData + 36);
+		Entry.bCanSkipStatus = (Flags & StageMask) == 0 && (Mode & ObjectTypeMask) == RegularFileType && !(ExtendedFlags & (SkipWorktreeFlag | IntentToAddFlag));
+	}
+
+	// Extensions: signature and size, an unknown extension starting with a lower case letter is required to understand the index
+	while(Offset + 8 <= End)
+	{
+		const uint8* Signature = Data + Offset;
+		const int64 Size = ReadUInt32BigEndian(Data + Offset + 4);
+		const uint8* ExtensionData = Data + Offset + 8;
+		if(Offset + 8 + Size > End)
+		{
+			return false;
+		}
+
+		if(FMemory::Memcmp(Signature, "TREE", 4) == 0)
+		{
+			if(!ParseCacheTree(ExtensionData, Size))
+			{
+				ValidTrees.Reset();
+			}
+		}
+		else if(Signature[0] >= 'a' && Signature[0] <= 'z')
+		{
+			// Split index ("link") and sparse index ("sdir"): the entries are not all in this file
+			GITCENTRAL_VERBOSE(TEXT("Index: unsupported extension %s"), *Utf8ToString(Signature, 4));
+			return false;
+		}
+		//Note: the untracked cache (UNTR) and fsmonitor (FSMN) extensions are not needed, the stat data of the files is compared to the disk directly
+
+		Offset += 8 + Size;
+	}
+
+	return true;
+}
+
+bool FGitIndex::ParseCacheTree(const uint8* InData, int64 InSize)
+{
+	// Each node: name, number of entries (-1 if invalidated), number of subtrees, then the tree id if valid.
+	// Nodes are written depth first, the root has an empty name.
+	struct FFrame
+	{
+		FString Path;
+		int32 RemainingSubtrees;
+	};
+	TArray<FFrame> Stack;
+
+	auto ParseNumber = [InData, InSize](int64& InOutOffset, uint8 InTerminator, int32& OutNumber)
+	{
+		bool bNegative = false;
+		if(InOutOffset < InSize && InData[InOutOffset] == '-')
+		{
+			bNegative = true;
+			++InOutOffset;
+		}
+
+		int64 Number = 0;
+		const int64 Start = InOutOffset;
+		while(InOutOffset < InSize && InData[InOutOffset] >= '0' && InData[InOutOffset] <= '9')
+		{
+			Number = Number * 10 + (InData[InOutOffset++] - '0');
+			if(Number > MAX_int32)
+			{
+				return false;
+			}
+		}
+
+		if(InOutOffset == Start || InOutOffset >= InSize || InData[InOutOffset] != InTerminator)
+		{
+			return false;
+		}
+		++InOutOffset;
+		OutNumber = bNegative ? -(int32)Number : (int32)Number;
+		return true;
+	};
+
+	int64 Offset = 0;
+	while(Offset < InSize)
+	{
+		const int64 NameLength = FindNul(InData, Offset, InSize);
+		if(NameLength == INDEX_NONE)
+		{
+			return false;
+		}
+		const FString Name = Utf8ToString(InData + Offset, (int32)NameLength);
+		Offset += NameLength + 1;
+
+		int32 NumEntries = 0;
+		int32 NumSubtrees = 0;
+		if(!ParseNumber(Offset, ' ', NumEntries) || !ParseNumber(Offset, '\n', NumSubtrees) || NumSubtrees < 0)
+		{
+			return false;
+		}
+
+		FString Path = Name;
+		if(Stack.Num())
+		{
+			FFrame& Parent = Stack.Last();
+			Path = Parent.Path.IsEmpty() ? Name : Parent.Path / Name;
+			--Parent.RemainingSubtrees;
+		}
+
+		if(NumEntries >= 0)
+		{
+			if(Offset + GitIndexConstants::HashSize > InSize)
+			{
+				return false;
+			}
+			FSHAHash& Tree = ValidTrees.Add(Path);
+			FMemory::Memcpy(Tree.Hash, InData + Offset, GitIndexConstants::HashSize);
+			Offset += GitIndexConstants::HashSize;
+		}
+
+		Stack.Add({ MoveTemp(Path), NumSubtrees });
+		while(Stack.Num() && Stack.Last().RemainingSubtrees <= 0)
+		{
+			Stack.Pop(false);
+		}
+	}
+
+	return true;
+}
+
+bool FGitIndex::IsDirectoryUnchanged(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InRelativeFile)
+{
+	// The closest valid tree of the cache-tree must be the same tree as in HEAD, which covers staged changes and modes
+	FString Directory = FPaths::GetPath(InRelativeFile);
+	while(true)
+	{
+		if(const FSHAHash* Tree = ValidTrees.Find(Directory))
+		{
+			FString* HeadTree = HeadTrees.Find(Directory);
+			if(!HeadTree)
+			{
+				FString Sha;
+				FString Type;
+				int64 Size = 0;
+				const FString ObjectName = Directory.IsEmpty() ? HeadSha + TEXT("^{tree}") : HeadSha + TEXT(":") + Directory;
+				FGitCatFileBatch& CatFile = FGitSourceControlModule::GetInstance().GetProvider().GetCatFileBatch();
+				if(CatFile.GetObjectInfo(InPathToGitBinary, InRepositoryRoot, ObjectName, Sha, Type, Size) != EGitCatFileResult::Found || Type != TEXT("tree"))
+				{
+					Sha.Reset();
+				}
+				HeadTree = &HeadTrees.Add(Directory, Sha);
+			}
+			return HeadTree->Equals(Tree->ToString(), ESearchCase::IgnoreCase);
+		}
+
+		if(Directory.IsEmpty())
+		{
+			return false;
+		}
+		Directory = FPaths::GetPath(Directory);
+	}
+}
+
+bool FGitIndex::IsFileUnchanged(const FString& InFile, const FEntry& InEntry) const
+{
+	const FFileStatData FileStat = FPlatformFileManager::Get().GetPlatformFile().GetStatData(*InFile);
+	if(!FileStat.bIsValid || FileStat.bIsDirectory || (uint32)FileStat.FileSize != InEntry.Size)
+	{
+		return false;
+	}
+
+	if(FileStat.ModificationTime.ToUnixTimestamp() != (int64)InEntry.ModificationSeconds)
+	{
+		return false;
+	}
+
+	//Note: some platforms only report whole seconds, sub-second times are only compared when available
+	const int64 SubSecondTicks = FileStat.ModificationTime.GetTicks() % ETimespan::TicksPerSecond;
+	if(SubSecondTicks != 0 && SubSecondTicks != InEntry.ModificationNanoseconds / ETimespan::NanosecondsPerTick)
+	{
+		return false;
+	}
+
+	// Racily clean: written in the same second as the index, the file may have changed after git looked at it
+	return (int64)InEntry.ModificationSeconds < IndexModificationTime.ToUnixTimestamp();
+}
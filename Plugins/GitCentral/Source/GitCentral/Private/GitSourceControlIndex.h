@@ -0,0 +1,78 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/SecureHash.h"
+
+/**
+ * Reader of the git index (.git/index, versions 2 to 4), telling unchanged files apart without running git status.
+ * A file is unchanged when its stat data on disk matches its index entry, and the cache-tree of the index says
+ * its directory is identical to the same directory in HEAD.
+ *
+ * Anything ambiguous is left to git status: racily clean entries (modified in the same second the index was written),
+ * conflicts, skip-worktree and intent-to-add entries, invalidated cache-trees, split and sparse indexes.
+ * The parsed index is kept until the file changes on disk. Thread safe.
+ */
+class FGitIndex
+{
+public:
+	/**
+	 * Find the files which are unchanged in the working copy and in the index, compared to HEAD
+	 * @param	InPathToGitBinary		The path to the Git binary
+	 * @param	InRepositoryRoot		The Git repository
+	 * @param	InFiles					Absolute paths of files in the repository
+	 * @param	OutUnchangedFiles		The files known to be unchanged
+	 * @param	OutOtherFiles			The files git status has to be asked about
+	 */
+	void SplitUnchangedFiles(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutUnchangedFiles, TArray<FString>& OutOtherFiles);
+
+	/** Forget the parsed index */
+	void Reset();
+
+private:
+	struct FEntry
+	{
+		/** Modification time and size of the file when it was last known unchanged by git, size truncated to 32 bits */
+		uint32 ModificationSeconds = 0;
+		uint32 ModificationNanoseconds = 0;
+		uint32 Size = 0;
+
+		/** Whether git status may be skipped for this entry: regular file, no conflict, no special flag */
+		bool bCanSkipStatus = false;
+	};
+
+	/** Parse the index file if it changed since it was last parsed */
+	bool Refresh(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+	/** Parse the content of an index file */
+	bool Parse(const TArray<uint8>& InData);
+
+	/** Parse the cache-tree extension, listing the directories of the index identical to a tree */
+	bool ParseCacheTree(const uint8* InData, int64 InSize);
+
+	/** Whether the index entries of the directory containing the file are the same as in HEAD */
+	bool IsDirectoryUnchanged(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InRelativeFile);
+
+	/** @returns whether the file on disk matches its index entry, and was not modified while the index was written */
+	bool IsFileUnchanged(const FString& InFile, const FEntry& InEntry) const;
+
+	FCriticalSection CriticalSection;
+
+	/** Repository and index file the index was parsed for */
+	FString RepositoryRoot;
+	FString IndexFile;
+	FDateTime IndexModificationTime;
+	int64 IndexSize = -1;
+
+	/** Index entries by path relative to the repository root */
+	TMap<FString, FEntry> Entries;
+
+	/** Directories of the cache-tree which are valid, relative to the repository root ("" for the root), to their tree */
+	TMap<FString, FSHAHash> ValidTrees;
+
+	/** Trees of HEAD already looked up, for HeadSha */
+	FString HeadSha;
+	TMap<FString, FString> HeadTrees;
+};
@@ -0,0 +1,41 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlLockCache.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+uint32 FGitLockCache::GetGeneration() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return Generation;
+}
+
+FGitStateMapPtr FGitLockCache::Find(const FString& InRepositoryRoot, double InMaxAge) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	if(Locks.IsValid() && InRepositoryRoot == RepositoryRoot && FPlatformTime::Seconds() - QuerySeconds <= InMaxAge)
+	{
+		return Locks;
+	}
+	return nullptr;
+}
+
+void FGitLockCache::Add(const FString& InRepositoryRoot, uint32 InGeneration, FGitStateMapPtr InLocks)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	if(InGeneration != Generation)
+	{
+		return;
+	}
+
+	RepositoryRoot = InRepositoryRoot;
+	Locks = MoveTemp(InLocks);
+	QuerySeconds = FPlatformTime::Seconds();
+}
+
+void FGitLockCache::Invalidate()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Locks.Reset();
+	Generation++;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "GitSourceControlRemoteDiffCache.h"
+
+/**
+ * The lfs locks of the repository, as last queried from the LFS server by git lfs locks.
+ * Refreshes of all files query the server and update the cache, the status of single files answered by the index reuse it
+ * instead of asking the server for each of them.
+ * Locking or unlocking files invalidates the cache, a query which started before cannot replace it with outdated locks.
+ * Thread safe, the locks are shared and never modified once cached.
+ */
+class FGitLockCache
+{
+public:
+	/** @returns the generation of the cache, to take before querying the locks and pass to Add */
+	uint32 GetGeneration() const;
+
+	/**
+	 * Find the locks of a repository
+	 * @param	InMaxAge	Seconds since the query after which the cached locks are outdated
+	 * @returns the cached locks, null if not cached or outdated
+	 */
+	FGitStateMapPtr Find(const FString& InRepositoryRoot, double InMaxAge) const;
+
+	/** Cache the locks of a repository, replacing the previous ones, unless the cache was invalidated since InGeneration was taken */
+	void Add(const FString& InRepositoryRoot, uint32 InGeneration, FGitStateMapPtr InLocks);
+
+	/** Forget the cached locks, they changed */
+	void Invalidate();
+
+private:
+	mutable FCriticalSection CriticalSection;
+
+	FString RepositoryRoot;
+	FGitStateMapPtr Locks;
+	double QuerySeconds = 0.0;
+	uint32 Generation = 0;
+};
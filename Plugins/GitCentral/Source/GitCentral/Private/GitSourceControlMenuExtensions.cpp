@@ -95,8 +95,9 @@ void FGitSourceControlMenuExtensions::AddSourceControlMenuExtension(FMenuBuilder
 	);
 
 	//Get latest
+	const bool bUpdatesAvailable = FGitSourceControlModule::GetInstance().GetProvider().GetFetchScheduler().AreUpdatesAvailable();
 	MenuBuilder.AddMenuEntry(
-		LOCTEXT("GitCentralGetLatestLabel", "Get Latest..."),
+		bUpdatesAvailable ? LOCTEXT("GitCentralGetLatestUpdatesLabel", "Get Latest (updates available)...") : LOCTEXT("GitCentralGetLatestLabel", "Get Latest..."),
 		LOCTEXT("GitCentralGetLatestTooltip", "Update all unchanged files to the latest version."),
 		FSlateIcon(FEditorStyle::GetStyleSetName(), "SourceControl.Actions.Sync"),
 		FUIAction(
@@ -598,6 +599,26 @@ void FGitSourceControlMenuExtensions::OnGetLatest()
 {
 	//This should call ContentBrowserUtils::SyncPackagesFromSourceControl but it is private so let's emulate it ourselves
 
+	FGitSourceControlModule& Module = FGitSourceControlModule::GetInstance();
+	FGitSourceControlProvider& Provider = Module.GetProvider();
+
+	//Nothing to pull if the remote branch did not move and has no commits missing from the local branch.
+	//Note: the background record may be outdated, the fetch probes the remote with ls-remote and compares it with the remote-tracking branch,
+	//only fetching if it moved, then records whether updates are available
+	const ECommandResult::Type FetchResult = Provider.Execute(ISourceControlOperation::Create<FGitFetch>(), TArray<FString>(), EConcurrency::Synchronous);
+	if(FetchResult == ECommandResult::Cancelled)
+	{
+		return;
+	}
+
+	if(FetchResult == ECommandResult::Succeeded && !Provider.GetFetchScheduler().AreUpdatesAvailable())
+	{
+		FMessageLog EditorErrors("EditorErrors");
+		EditorErrors.Info(LOCTEXT("GetLatestUpToDate", "Already up to date, there is nothing to Get Latest."));
+		EditorErrors.Notify();
+		return;
+	}
+
 	//Prompt to save or discard all packages
 	bool bOkToExit = false;
 	bool bHadPackagesToSave = false;
@@ -629,11 +650,6 @@ void FGitSourceControlMenuExtensions::OnGetLatest()
 		return;
 	}
 
-	//TODO: we could check if there is update available before even attempting to get latest
-
-	FGitSourceControlModule& Module = FGitSourceControlModule::GetInstance();
-	FGitSourceControlProvider& Provider = Module.GetProvider();
-
 	//Find all packages in repository
 	TArray<FString> PackageRelativePaths;
 	FPackageName::FindPackagesInDirectory(PackageRelativePaths, *Provider.GetPathToRepositoryRoot());
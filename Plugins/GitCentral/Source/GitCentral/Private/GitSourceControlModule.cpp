@@ -30,6 +30,7 @@ void FGitSourceControlModule::StartupModule()
 	GitSourceControlProvider.RegisterWorker("Resolve", FGetGitSourceControlWorker::CreateStatic(&CreateWorker<FGitResolveWorker>));
 	GitSourceControlProvider.RegisterWorker("ForceUnlock", FGetGitSourceControlWorker::CreateStatic(&CreateWorker<FGitForceUnlockWorker>));
 	GitSourceControlProvider.RegisterWorker("ForceWriteable", FGetGitSourceControlWorker::CreateStatic(&CreateWorker<FGitForceWriteableWorker>));
+	GitSourceControlProvider.RegisterWorker("Fetch", FGetGitSourceControlWorker::CreateStatic(&CreateWorker<FGitFetchWorker>));
 
 	// load our settings
 	GitSourceControlSettings.LoadSettings();
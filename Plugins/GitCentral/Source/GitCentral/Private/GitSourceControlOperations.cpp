@@ -18,6 +18,11 @@ FName FGitConnectWorker::GetName() const
 	return "Connect";
 }
 
+EGitCommandPriority::Type FGitConnectWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitConnectWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
@@ -41,6 +46,9 @@ bool FGitConnectWorker::Execute(FGitSourceControlCommand& InCommand)
 		}
 	}
 
+	//Report settings that make status slow on large repositories
+	GitSourceControlUtils::RunRepositoryDoctor(InCommand);
+
 	//List all remote branches
 	//Could also skip this step and run fetch directly
 	TArray<FString> Parameters;
@@ -114,6 +122,11 @@ FName FGitCheckOutWorker::GetName() const
 	return "CheckOut";
 }
 
+EGitCommandPriority::Type FGitCheckOutWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitCheckOutWorker::Execute(class FGitSourceControlCommand& InCommand)
 {
 	//Note: This does ever get latest. Checking out an outdated file will result in a conflict
@@ -291,13 +304,11 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 	FilesToAdd.Reserve(InCommand.Files.Num());
 
 	{
-		TArray<FString> StatusResults;
 		TMap<FString, FGitSourceControlState> StatusStates;
 
 		//Note: if a file is in a new folder, git status --porcelain without parameters will only return the directory status. We pass the filenames to ensure the returned status maps to the actual files.
 		//Another option would be to use -u to show all untracked files in directories but it would not limit files in the command parameters
-		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("status --porcelain"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, StatusResults, InCommand.ErrorMessages);
-		GitSourceControlUtils::ParseStatusResults(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, {}, StatusResults, StatusStates);
+		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, StatusStates, InCommand.ErrorMessages);
 
 		for(auto& State : StatusStates)
 		{
@@ -339,6 +350,8 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 
 	if(InCommand.bCommandSuccessful)
 	{
+		GitSourceControlUtils::UpdateCommitGraph(InCommand);
+
 		const FString NewCommitSha = GitSourceControlUtils::GetCommitShaForBranch(InCommand.Branch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
 
 		// Update Saved State and Have Revision of files we just pushed
@@ -415,6 +428,9 @@ bool FGitCheckInWorker::UpdateStates() const
 
 void FGitCheckInWorker::Cleanup(FGitSourceControlCommand& InCommand, bool bShouldReset)
 {
+	//Rolling back must complete even if the command was cancelled
+	FGitScopedIgnoreCancel IgnoreCancel(InCommand);
+
 	//Something went wrong, let's get back to where we started
 	if(bShouldReset || !InCommand.bCommandSuccessful)
 	{
@@ -461,6 +477,11 @@ FName FGitMarkForAddWorker::GetName() const
 	return "MarkForAdd";
 }
 
+EGitCommandPriority::Type FGitMarkForAddWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitMarkForAddWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
@@ -488,6 +509,11 @@ FName FGitDeleteWorker::GetName() const
 	return "Delete";
 }
 
+EGitCommandPriority::Type FGitDeleteWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitDeleteWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	//TODO: this could push on delete for assets that are source controlled, 
@@ -559,6 +585,11 @@ FName FGitRevertWorker::GetName() const
 	return "Revert";
 }
 
+EGitCommandPriority::Type FGitRevertWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
@@ -618,16 +649,36 @@ FName FGitUpdateStatusWorker::GetName() const
 	return "UpdateStatus";
 }
 
+bool FGitUpdateStatusWorker::IsReadOnly() const
+{
+	//Note: fetch writes remote-tracking refs and FETCH_HEAD, RunFetch serializes the fetches. Status only refreshes the index when it can take its lock
+	return true;
+}
+
+EGitCommandPriority::Type FGitUpdateStatusWorker::GetPriority() const
+{
+	return EGitCommandPriority::Background;
+}
+
 bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
 
-	//must fetch before updating status
-	//TODO Optimize for less agressive fetch as this is the slowest part of updating the status
-	//Ideas: if fetch did not update the sha just update local status as remote status has not changed
-	//Only fetch on timer expired or on meaningful operations (push/pull)
-	InCommand.bCommandSuccessful = GitSourceControlUtils::RunFetch(InCommand);
-	bConnected = InCommand.bCommandSuccessful;
+	//Fetching is the slowest part of updating the status: the remote branch is kept fetched in the background,
+	//the status only fetches when the last fetch is too old, or when the caller explicitly waits for an up to date status
+	FGitSourceControlModule& GitSourceControlModule = FGitSourceControlModule::GetInstance();
+	FGitFetchScheduler& FetchScheduler = GitSourceControlModule.GetProvider().GetFetchScheduler();
+	if(InCommand.Concurrency == EConcurrency::Synchronous
+		|| FetchScheduler.IsStale(InCommand.PathToRepositoryRoot, GitSourceControlModule.AccessSettings().GetFetchStalenessBudget()))
+	{
+		InCommand.bCommandSuccessful = GitSourceControlUtils::RunFetch(InCommand);
+		bConnected = InCommand.bCommandSuccessful;
+	}
+	else
+	{
+		InCommand.bCommandSuccessful = true;
+		bConnected = FetchScheduler.WasLastFetchSuccessful();
+	}
 
 	TSharedRef<FUpdateStatus, ESPMode::ThreadSafe> Operation = StaticCastSharedRef<FUpdateStatus>(InCommand.Operation);
 
@@ -638,14 +689,60 @@ bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 	}
 	else if(Operation->ShouldCheckAllFiles() || Operation->ShouldGetOpenedOnly())
 	{
+		FGitSourceControlModule& GitSourceControl = FGitSourceControlModule::GetInstance();
+
 		FString RepositoryRootArg = InCommand.PathToRepositoryRoot;
 		if(!RepositoryRootArg.EndsWith("/"))
 			RepositoryRootArg += '/';
 
-		//Note: this will not update states properly as files that are newly unmodified will not appear and therefore their state will not be refreshed
-		//If this becomes a problem, this method must pass all currently cached filenames to the update status routine
+		//Only the paths changed on disk need a refresh as long as the local and remote branches did not move since the last full scan
+		FGitDirtyPathTracker& DirtyPathTracker = GitSourceControl.GetProvider().GetDirtyPathTracker();
+		const FString HeadSha = GitSourceControlUtils::GetCommitShaForBranch(InCommand.Branch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+		const FString RemoteSha = GitSourceControlUtils::GetCommitShaForBranch(InCommand.GetRemoteBranch(), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+
+		//Locks taken or released by other users change files which did not change on disk, and which a status of the repository does not list
+		FGitStateMapPtr Locks;
+		TArray<FString> LockChangedFiles;
+		if(InCommand.bUseLocking)
+		{
+			TArray<FString> LockErrors;
+			if(GitSourceControlUtils::RunGetLocks(InCommand, Locks, LockErrors))
+			{
+				GitSourceControlUtils::GetFilesWithChangedLocks(*Locks, LockChangedFiles);
+			}
+			else
+			{
+				//Note: queried again and reported by RunUpdateStatus
+				Locks.Reset();
+			}
+		}
+
+		TArray<FString> DirtyPaths;
+		uint32 ScanEpoch = 0;
+		if(DirtyPathTracker.ConsumeDirtyPaths(HeadSha, RemoteSha, DirtyPaths, ScanEpoch))
+		{
+			GITCENTRAL_VERBOSE(TEXT("UpdateStatus: %d paths changed since the last refresh, %d locks changed"), DirtyPaths.Num(), LockChangedFiles.Num());
+			DirtyPaths.Append(LockChangedFiles);
+			InCommand.bCommandSuccessful = DirtyPaths.Num() == 0 || GitSourceControlUtils::RunUpdateStatus(InCommand, DirtyPaths, InCommand.ErrorMessages, States, Locks);
+		}
+		else
+		{
+			//Note: this will not update states properly as files that are newly unmodified will not appear and therefore their state will not be refreshed
+			//If this becomes a problem, this method must pass all currently cached filenames to the update status routine
+			TArray<FString> ScanPaths = { RepositoryRootArg };
+			ScanPaths.Append(LockChangedFiles);
+			InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand, ScanPaths, InCommand.ErrorMessages, States, Locks);
+			if(InCommand.bCommandSuccessful)
+			{
+				DirtyPathTracker.OnFullScanCompleted(HeadSha, RemoteSha, ScanEpoch);
+			}
+		}
 
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand, { RepositoryRootArg }, InCommand.ErrorMessages, States);
+		//The changes were consumed, they must not be lost
+		if(!InCommand.bCommandSuccessful)
+		{
+			DirtyPathTracker.RequestFullScan();
+		}
 		GitSourceControlUtils::RemoveRedundantErrors(InCommand, TEXT("' is outside repository"));
 	}
 
@@ -675,11 +772,13 @@ bool FGitUpdateStatusWorker::UpdateStates() const
 	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
 
 	// add history, if any
-	for(const auto& History : Histories)
+	if(Histories.Num() > 0)
 	{
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = Provider.GetStateInternal(History.Key);
-		State->History = History.Value;
-		State->TimeStamp = FDateTime::Now();
+		Provider.GetStateStore().SetHistories(Histories);
+
+		TArray<FString> ChangedFiles;
+		Histories.GetKeys(ChangedFiles);
+		Provider.AddChangedFiles(ChangedFiles);
 		bUpdated = true;
 	}
 
@@ -698,6 +797,11 @@ FName FGitCopyWorker::GetName() const
 	return "Copy";
 }
 
+EGitCommandPriority::Type FGitCopyWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitCopyWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
@@ -727,6 +831,11 @@ FName FGitResolveWorker::GetName() const
 	return "Resolve";
 }
 
+EGitCommandPriority::Type FGitResolveWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitResolveWorker::Execute( class FGitSourceControlCommand& InCommand )
 {
 	//Note: this assumes resolve using mine, and keeps the file checked out
@@ -800,7 +909,12 @@ bool FGitSyncWorker::Execute(class FGitSourceControlCommand& InCommand)
 	if(InCommand.Files.Num() == 1 && InCommand.Files[0] == InCommand.PathToRepositoryRoot)
 	{
 		//Base directory: get latest for all the files
-		return GetLatest(InCommand);
+		const bool bSynced = GetLatest(InCommand);
+		if(bSynced)
+		{
+			FGitSourceControlModule::GetInstance().GetProvider().GetFetchScheduler().ClearUpdatesAvailable();
+		}
+		return bSynced;
 	}
 	else //command is called for directories and/or individual files, sync them
 	{
@@ -984,6 +1098,7 @@ bool FGitSyncWorker::GetLatest(class FGitSourceControlCommand& InCommand)
 
 		if(!InCommand.bCommandSuccessful)
 		{
+			FGitScopedIgnoreCancel IgnoreCancel(InCommand);
 			GitSourceControlUtils::RunCommand(TEXT("reset"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, InCommand.ErrorMessages);
 			StatusFile.ClearCache();
 			return false;
@@ -992,24 +1107,18 @@ bool FGitSyncWorker::GetLatest(class FGitSourceControlCommand& InCommand)
 
 	// List all the files that will be changed
 	{
-		TArray<FString> StdOut;
 		TArray<FString> StdErr;
 
-		TArray<FString> Parameters;
-		Parameters.Add(MergeBase);
-		Parameters.Add(RemoteBranch);
-		//diff all files from the server but will only keep states that we are interested in
+		//diff all files from the server but will only keep states that we are interested in, usually already cached by the status updates
 		//TODO: Maybe this would be better with a log and aggregating what happened as we can miss some add+delete cases with git diff
 		//git log --name-status --pretty=format:"> %h %s" --reverse
 
-		TMap<FString, FGitSourceControlState> RemoteStates;
-		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("diff --name-status"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
+		FGitStateMapPtr RemoteStates;
+		InCommand.bCommandSuccessful &= GitSourceControlUtils::GetRemoteDiff(InCommand, MergeBase, RemoteSha, RemoteStates, StdErr);
 		if (InCommand.bCommandSuccessful)
 		{
-			GitSourceControlUtils::ParseNameStatusResults(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, StdOut, RemoteStates);
-
-			UpdatedFiles.Reserve(RemoteStates.Num());
-			for (const auto& RemoteState : RemoteStates)
+			UpdatedFiles.Reserve(RemoteStates->Num());
+			for (const auto& RemoteState : *RemoteStates)
 			{
 				UpdatedFiles.Add(RemoteState.Value.GetFilename());
 			}
@@ -1042,10 +1151,8 @@ bool FGitSyncWorker::GetLatest(class FGitSourceControlCommand& InCommand)
 			PullRebaseResult.Reset();
 
 			TArray<FString> StdOut;
-			GitSourceControlUtils::RunCommand(TEXT("status --porcelain"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, InCommand.ErrorMessages);
-
 			TMap<FString, FGitSourceControlState> StatusResult;
-			GitSourceControlUtils::ParseStatusResults(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), StdOut, StatusResult);
+			GitSourceControlUtils::RunStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StatusResult, InCommand.ErrorMessages);
 
 			for(auto It : StatusResult)
 			{
@@ -1080,6 +1187,7 @@ bool FGitSyncWorker::GetLatest(class FGitSourceControlCommand& InCommand)
 		//failure during rebase, abort rebase
 		if(!InCommand.bCommandSuccessful)
 		{
+			FGitScopedIgnoreCancel IgnoreCancel(InCommand);
 			InCommand.ErrorMessages.Append(StdErr);
 			GitSourceControlUtils::RunCommand(TEXT("rebase --abort"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
 			if(bStash)
@@ -1090,10 +1198,15 @@ bool FGitSyncWorker::GetLatest(class FGitSourceControlCommand& InCommand)
 
 		//Note: git checkout --theirs outputs an error when resolving a conflict: Updated 1 path from the index
 		GitSourceControlUtils::RemoveRedundantErrors(InCommand, TEXT("path from the index"));
+
+		GitSourceControlUtils::UpdateCommitGraph(InCommand);
 	}
 
 	if(InCommand.bCommandSuccessful && bStash)
 	{
+		//The pull went through, local changes must be restored even if the command was cancelled
+		FGitScopedIgnoreCancel IgnoreCancel(InCommand);
+
 		TArray<FString> StdOut;
 		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("stash pop"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, InCommand.ErrorMessages);
 
@@ -1158,6 +1271,58 @@ bool FGitSyncWorker::UpdateStates() const
 
 //////////////////////////////////////////////////////////////////////////
 
+FText FGitFetch::GetInProgressString() const
+{
+	return LOCTEXT("SourceControl_Fetch", "Fetching remote branch...");
+}
+
+FName FGitFetchWorker::GetName() const
+{
+	return "Fetch";
+}
+
+bool FGitFetchWorker::IsReadOnly() const
+{
+	//Note: fetch only writes remote-tracking refs and FETCH_HEAD, like the fetch of UpdateStatus, RunFetch serializes the fetches
+	return true;
+}
+
+EGitCommandPriority::Type FGitFetchWorker::GetPriority() const
+{
+	return EGitCommandPriority::Background;
+}
+
+bool FGitFetchWorker::Execute(FGitSourceControlCommand& InCommand)
+{
+	check(InCommand.Operation->GetName() == GetName());
+
+	const FString RemoteBranch = InCommand.GetRemoteBranch();
+	const FString OldRemoteSha = GitSourceControlUtils::GetCommitShaForBranch(RemoteBranch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+
+	InCommand.bCommandSuccessful = GitSourceControlUtils::RunFetch(InCommand);
+	bConnected = InCommand.bCommandSuccessful;
+
+	if(InCommand.bCommandSuccessful)
+	{
+		const FString NewRemoteSha = GitSourceControlUtils::GetCommitShaForBranch(RemoteBranch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+		StaticCastSharedRef<FGitFetch>(InCommand.Operation)->SetRemoteChanged(NewRemoteSha != OldRemoteSha);
+	}
+
+	return InCommand.bCommandSuccessful;
+}
+
+bool FGitFetchWorker::UpdateStates() const
+{
+	return false;
+}
+
+bool FGitFetchWorker::IsConnected() const
+{
+	return bConnected;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 FText FForceUnlock::GetInProgressString() const
 {
 	return LOCTEXT("SourceControl_ForceUnlock", "Force Unlocking files...");
@@ -1168,6 +1333,11 @@ FName FGitForceUnlockWorker::GetName() const
 	return "ForceUnlock";
 }
 
+EGitCommandPriority::Type FGitForceUnlockWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitForceUnlockWorker::Execute(class FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
@@ -1213,6 +1383,11 @@ FName FGitForceWriteableWorker::GetName() const
 	return "ForceWriteable";
 }
 
+EGitCommandPriority::Type FGitForceWriteableWorker::GetPriority() const
+{
+	return EGitCommandPriority::Interactive;
+}
+
 bool FGitForceWriteableWorker::Execute(class FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
@@ -18,6 +18,7 @@ public:
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
 	virtual bool IsConnected() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	bool bConnected;
@@ -32,6 +33,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	/** Temporary states for results */
@@ -66,6 +68,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	/** Temporary states for results */
@@ -81,6 +84,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	/** Temporary states for results */
@@ -96,6 +100,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	/** Map of filenames to Git state */
@@ -134,6 +139,8 @@ public:
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
 	virtual bool IsConnected() const override;
+	virtual bool IsReadOnly() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	/** Temporary states for results */
@@ -154,6 +161,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 };
 
 /** Resovles the state by marking it in the status file */ 
@@ -164,6 +172,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 	
 private:
 	/** Temporary states for results */
@@ -174,6 +183,43 @@ private:
 // End of standard operations and workers
 //////////////////////////////////////////////////////////////////////////
 
+/**
+ * Operation to fetch the remote branch, issued in the background by the FGitFetchScheduler
+ */
+class FGitFetch : public FSourceControlOperationBase
+{
+public:
+	// ISourceControlOperation interface
+	virtual FName GetName() const override
+	{
+		return "Fetch";
+	}
+
+	virtual FText GetInProgressString() const override;
+
+	/** Whether the fetch moved the remote branch */
+	bool HasRemoteChanged() const { return bRemoteChanged; }
+	void SetRemoteChanged(bool bInRemoteChanged) { bRemoteChanged = bInRemoteChanged; }
+
+private:
+	bool bRemoteChanged = false;
+};
+
+class FGitFetchWorker : public IGitSourceControlWorker
+{
+public:
+	virtual ~FGitFetchWorker() {}
+	virtual FName GetName() const override;
+	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
+	virtual bool UpdateStates() const override;
+	virtual bool IsConnected() const override;
+	virtual bool IsReadOnly() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
+
+private:
+	bool bConnected = false;
+};
+
 /**
  * Operation to force unlock of locked files
  */
@@ -197,6 +243,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	/** Temporary states for results */
@@ -226,6 +273,7 @@ public:
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
 	virtual bool UpdateStates() const override;
+	virtual EGitCommandPriority::Type GetPriority() const override;
 
 private:
 	/** Temporary states for results */
@@ -0,0 +1,647 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlProcess.h"
+#include "GitSourceControlModule.h"
+#include "Misc/ScopeLock.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsHWrapper.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if PLATFORM_MAC
+#include <crt_externs.h>
+#else
+extern char** environ;
+#endif
+#endif
+
+namespace GitProcessConstants
+{
+	/** Size of the chunks read from the pipes */
+	const int32 ReadChunkSize = 64 * 1024;
+
+	/** Time given to a process to exit by itself once its stdin is closed */
+	const double CloseTimeout = 2.0;
+}
+
+FGitProcess::FGitProcess()
+	: ReturnCode(-1)
+	, bRunning(false)
+#if PLATFORM_WINDOWS
+	, ProcessHandle(nullptr)
+	, StdInWrite(nullptr)
+	, StdOutRead(nullptr)
+	, StdErrRead(nullptr)
+#else
+	, ProcessId(-1)
+	, StdInWrite(-1)
+	, StdOutRead(-1)
+	, StdErrRead(-1)
+#endif
+{
+}
+
+FGitProcess::~FGitProcess()
+{
+	Close();
+}
+
+void FGitProcess::WaitBackOff(int32& InOutIdleIterations)
+{
+	//Note: most git queries answer within microseconds, only start sleeping if the process is actually busy
+	if(InOutIdleIterations++ < 64)
+	{
+		FPlatformProcess::Sleep(0.0f);
+	}
+	else
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+}
+
+bool FGitProcess::WriteStdInLine(const FString& InLine)
+{
+	FTCHARToUTF8 Converted(*InLine);
+	TArray<uint8> Data;
+	Data.Reserve(Converted.Length() + 1);
+	Data.Append((const uint8*)Converted.Get(), Converted.Length());
+	Data.Add('\n');
+	return WriteStdIn(Data.GetData(), Data.Num());
+}
+
+#if PLATFORM_WINDOWS
+
+// Creates a pipe where only the child end is inheritable
+static bool CreateChildPipe(HANDLE& OutRead, HANDLE& OutWrite, bool bChildReads)
+{
+	SECURITY_ATTRIBUTES Attr = { sizeof(SECURITY_ATTRIBUTES), NULL, true };
+	if(!::CreatePipe(&OutRead, &OutWrite, &Attr, 0))
+	{
+		return false;
+	}
+
+	if(!::SetHandleInformation(bChildReads ? OutWrite : OutRead, HANDLE_FLAG_INHERIT, 0))
+	{
+		::CloseHandle(OutRead);
+		::CloseHandle(OutWrite);
+		return false;
+	}
+
+	return true;
+}
+
+bool FGitProcess::Launch(const FString& InPathToGitBinary, const FString& InParams, bool bInWithStdIn)
+{
+	check(!IsValid());
+	ReturnCode = -1;
+
+	HANDLE StdInReadChild = nullptr, StdInWriteParent = nullptr;
+	HANDLE StdOutReadParent = nullptr, StdOutWriteChild = nullptr;
+	HANDLE StdErrReadParent = nullptr, StdErrWriteChild = nullptr;
+
+	if(!CreateChildPipe(StdInReadChild, StdInWriteParent, true))
+	{
+		return false;
+	}
+	if(!CreateChildPipe(StdOutReadParent, StdOutWriteChild, false))
+	{
+		::CloseHandle(StdInReadChild);
+		::CloseHandle(StdInWriteParent);
+		return false;
+	}
+	if(!CreateChildPipe(StdErrReadParent, StdErrWriteChild, false))
+	{
+		::CloseHandle(StdInReadChild);
+		::CloseHandle(StdInWriteParent);
+		::CloseHandle(StdOutReadParent);
+		::CloseHandle(StdOutWriteChild);
+		return false;
+	}
+
+	//Note: the child ends are inheritable until they are closed, a process launched concurrently by another thread would inherit them too
+	//and keep the pipes open, only the handles of this child are passed to it
+	HANDLE ChildHandles[] = { StdInReadChild, StdOutWriteChild, StdErrWriteChild };
+	SIZE_T AttributeListSize = 0;
+	::InitializeProcThreadAttributeList(nullptr, 1, 0, &AttributeListSize);
+	TArray<uint8> AttributeListBuffer;
+	AttributeListBuffer.SetNumZeroed(AttributeListSize);
+	LPPROC_THREAD_ATTRIBUTE_LIST AttributeList = (LPPROC_THREAD_ATTRIBUTE_LIST)AttributeListBuffer.GetData();
+	const bool bAttributesSet = ::InitializeProcThreadAttributeList(AttributeList, 1, 0, &AttributeListSize)
+		&& ::UpdateProcThreadAttribute(AttributeList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, ChildHandles, sizeof(ChildHandles), nullptr, nullptr);
+
+	STARTUPINFOEXW StartupInfo;
+	FMemory::Memzero(StartupInfo);
+	StartupInfo.StartupInfo.cb = sizeof(StartupInfo);
+	StartupInfo.StartupInfo.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+	StartupInfo.StartupInfo.wShowWindow = SW_HIDE;
+	StartupInfo.StartupInfo.hStdInput = StdInReadChild;
+	StartupInfo.StartupInfo.hStdOutput = StdOutWriteChild;
+	StartupInfo.StartupInfo.hStdError = StdErrWriteChild;
+	StartupInfo.lpAttributeList = AttributeList;
+
+	FString CommandLine = FString::Printf(TEXT("\"%s\" %s"), *InPathToGitBinary, *InParams);
+	TArray<TCHAR> CommandLineBuffer(*CommandLine, CommandLine.Len() + 1);
+
+	PROCESS_INFORMATION ProcessInfo;
+	FMemory::Memzero(ProcessInfo);
+	const bool bCreated = bAttributesSet && !!::CreateProcessW(nullptr, CommandLineBuffer.GetData(), nullptr, nullptr, true, CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT,
+		nullptr, nullptr, &StartupInfo.StartupInfo, &ProcessInfo);
+	if(bAttributesSet)
+	{
+		::DeleteProcThreadAttributeList(AttributeList);
+	}
+
+	// The child ends now belong to the child
+	::CloseHandle(StdInReadChild);
+	::CloseHandle(StdOutWriteChild);
+	::CloseHandle(StdErrWriteChild);
+
+	if(!bCreated)
+	{
+		GITCENTRAL_ERROR(TEXT("Failed to launch '%s' (error %u)"), *InPathToGitBinary, ::GetLastError());
+		::CloseHandle(StdInWriteParent);
+		::CloseHandle(StdOutReadParent);
+		::CloseHandle(StdErrReadParent);
+		return false;
+	}
+
+	::CloseHandle(ProcessInfo.hThread);
+	ProcessHandle = ProcessInfo.hProcess;
+	StdOutRead = StdOutReadParent;
+	StdErrRead = StdErrReadParent;
+	StdInWrite = StdInWriteParent;
+	bRunning = true;
+
+	if(!bInWithStdIn)
+	{
+		CloseStdIn();
+	}
+
+	return true;
+}
+
+bool FGitProcess::IsValid() const
+{
+	return ProcessHandle != nullptr;
+}
+
+bool FGitProcess::IsRunning()
+{
+	if(!bRunning)
+	{
+		return false;
+	}
+
+	if(::WaitForSingleObject(ProcessHandle, 0) == WAIT_TIMEOUT)
+	{
+		return true;
+	}
+
+	DWORD ExitCode = 0;
+	ReturnCode = ::GetExitCodeProcess(ProcessHandle, &ExitCode) ? (int32)ExitCode : -1;
+	bRunning = false;
+	return false;
+}
+
+static int32 ReadAvailable(void* InPipe, TArray<uint8>& OutData)
+{
+	if(InPipe == nullptr)
+	{
+		return 0;
+	}
+
+	int32 TotalRead = 0;
+	DWORD BytesAvailable = 0;
+	while(::PeekNamedPipe(InPipe, nullptr, 0, nullptr, &BytesAvailable, nullptr) && BytesAvailable > 0)
+	{
+		const int32 Offset = OutData.AddUninitialized(BytesAvailable);
+		DWORD BytesRead = 0;
+		if(!::ReadFile(InPipe, OutData.GetData() + Offset, BytesAvailable, &BytesRead, nullptr))
+		{
+			OutData.SetNum(Offset, false);
+			break;
+		}
+		OutData.SetNum(Offset + BytesRead, false);
+		TotalRead += BytesRead;
+	}
+	return TotalRead;
+}
+
+int32 FGitProcess::ReadStdOut(TArray<uint8>& OutData)
+{
+	return ReadAvailable(StdOutRead, OutData);
+}
+
+int32 FGitProcess::ReadStdErr(TArray<uint8>& OutData)
+{
+	return ReadAvailable(StdErrRead, OutData);
+}
+
+bool FGitProcess::WriteStdIn(const uint8* InData, int32 InSize)
+{
+	if(StdInWrite == nullptr)
+	{
+		return false;
+	}
+
+	while(InSize > 0)
+	{
+		DWORD BytesWritten = 0;
+		if(!::WriteFile(StdInWrite, InData, InSize, &BytesWritten, nullptr))
+		{
+			return false;
+		}
+		InData += BytesWritten;
+		InSize -= BytesWritten;
+	}
+	return true;
+}
+
+void FGitProcess::CloseStdIn()
+{
+	if(StdInWrite != nullptr)
+	{
+		::CloseHandle(StdInWrite);
+		StdInWrite = nullptr;
+	}
+}
+
+void FGitProcess::Terminate()
+{
+	if(IsRunning())
+	{
+		FProcHandle Handle(ProcessHandle);
+		FPlatformProcess::TerminateProc(Handle, true);
+		::WaitForSingleObject(ProcessHandle, INFINITE);
+		bRunning = false;
+		ReturnCode = -1;
+	}
+}
+
+void FGitProcess::ReleaseHandles()
+{
+	CloseStdIn();
+	if(StdOutRead != nullptr)
+	{
+		::CloseHandle(StdOutRead);
+		StdOutRead = nullptr;
+	}
+	if(StdErrRead != nullptr)
+	{
+		::CloseHandle(StdErrRead);
+		StdErrRead = nullptr;
+	}
+	if(ProcessHandle != nullptr)
+	{
+		::CloseHandle(ProcessHandle);
+		ProcessHandle = nullptr;
+	}
+}
+
+#else // PLATFORM_WINDOWS
+
+// Split a command line the way a shell would for our usage: arguments are separated by spaces and may be double-quoted
+static void SplitCommandLine(const FString& InParams, TArray<FString>& OutArgs)
+{
+	FString Current;
+	bool bInQuotes = false;
+	bool bHasArg = false;
+	for(const TCHAR Char : InParams)
+	{
+		if(Char == TEXT('"'))
+		{
+			bInQuotes = !bInQuotes;
+			bHasArg = true;
+		}
+		else if(!bInQuotes && FChar::IsWhitespace(Char))
+		{
+			if(bHasArg)
+			{
+				OutArgs.Add(MoveTemp(Current));
+				Current.Reset();
+				bHasArg = false;
+			}
+		}
+		else
+		{
+			Current.AppendChar(Char);
+			bHasArg = true;
+		}
+	}
+	if(bHasArg)
+	{
+		OutArgs.Add(MoveTemp(Current));
+	}
+}
+
+static bool CreateChildPipe(int32& OutRead, int32& OutWrite, bool bChildReads)
+{
+	// Neither end should leak into other children, dup2 in the child clears the flag on the redirected descriptor
+	int32 Fds[2];
+#if PLATFORM_LINUX
+	// Atomically, a process spawned concurrently by another thread would inherit the pipe otherwise
+	if(pipe2(Fds, O_CLOEXEC) != 0)
+	{
+		return false;
+	}
+#else
+	// Not atomic, Launch holds the launch lock
+	if(pipe(Fds) != 0)
+	{
+		return false;
+	}
+	fcntl(Fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(Fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+	// Parent reads must never block
+	if(!bChildReads)
+	{
+		fcntl(Fds[0], F_SETFL, fcntl(Fds[0], F_GETFL) | O_NONBLOCK);
+	}
+#if PLATFORM_MAC
+	else
+	{
+		// Writing to a dead child must not raise SIGPIPE
+		fcntl(Fds[1], F_SETNOSIGPIPE, 1);
+	}
+#endif
+
+	OutRead = Fds[0];
+	OutWrite = Fds[1];
+	return true;
+}
+
+bool FGitProcess::Launch(const FString& InPathToGitBinary, const FString& InParams, bool bInWithStdIn)
+{
+	check(!IsValid());
+	ReturnCode = -1;
+
+#if !PLATFORM_MAC
+	// Writing to a dead child must not kill the editor
+	static const bool bIgnoreSigPipe = [] { signal(SIGPIPE, SIG_IGN); return true; }();
+	(void)bIgnoreSigPipe;
+#endif
+
+#if !PLATFORM_LINUX
+	// Without pipe2, no pipe may be created by another launch between pipe() and FD_CLOEXEC while a child is spawned
+	static FCriticalSection LaunchCriticalSection;
+	FScopeLock LaunchLock(&LaunchCriticalSection);
+#endif
+
+	int32 StdInReadChild = -1, StdInWriteParent = -1;
+	int32 StdOutReadParent = -1, StdOutWriteChild = -1;
+	int32 StdErrReadParent = -1, StdErrWriteChild = -1;
+
+	if(!CreateChildPipe(StdInReadChild, StdInWriteParent, true))
+	{
+		return false;
+	}
+	if(!CreateChildPipe(StdOutReadParent, StdOutWriteChild, false))
+	{
+		close(StdInReadChild);
+		close(StdInWriteParent);
+		return false;
+	}
+	if(!CreateChildPipe(StdErrReadParent, StdErrWriteChild, false))
+	{
+		close(StdInReadChild);
+		close(StdInWriteParent);
+		close(StdOutReadParent);
+		close(StdOutWriteChild);
+		return false;
+	}
+
+	TArray<FString> Args;
+	Args.Add(InPathToGitBinary);
+	SplitCommandLine(InParams, Args);
+
+	TArray<TArray<ANSICHAR>> ArgsUtf8;
+	TArray<char*> Argv;
+	ArgsUtf8.Reserve(Args.Num());
+	for(const FString& Arg : Args)
+	{
+		FTCHARToUTF8 Converted(*Arg);
+		TArray<ANSICHAR>& ArgUtf8 = ArgsUtf8.AddDefaulted_GetRef();
+		ArgUtf8.Append(Converted.Get(), Converted.Length());
+		ArgUtf8.Add('\0');
+		Argv.Add(ArgUtf8.GetData());
+	}
+	Argv.Add(nullptr);
+
+	posix_spawn_file_actions_t FileActions;
+	posix_spawn_file_actions_init(&FileActions);
+	posix_spawn_file_actions_adddup2(&FileActions, StdInReadChild, STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&FileActions, StdOutWriteChild, STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&FileActions, StdErrWriteChild, STDERR_FILENO);
+
+	// Run in a new process group so that the whole process tree can be terminated
+	posix_spawnattr_t SpawnAttr;
+	posix_spawnattr_init(&SpawnAttr);
+	posix_spawnattr_setflags(&SpawnAttr, POSIX_SPAWN_SETPGROUP);
+	posix_spawnattr_setpgroup(&SpawnAttr, 0);
+
+#if PLATFORM_MAC
+	char** Environment = *_NSGetEnviron();
+#else
+	char** Environment = environ;
+#endif
+
+	pid_t ChildId = -1;
+	const int32 SpawnResult = posix_spawnp(&ChildId, Argv[0], &FileActions, &SpawnAttr, Argv.GetData(), Environment);
+
+	posix_spawn_file_actions_destroy(&FileActions);
+	posix_spawnattr_destroy(&SpawnAttr);
+
+	// The child ends now belong to the child
+	close(StdInReadChild);
+	close(StdOutWriteChild);
+	close(StdErrWriteChild);
+
+	if(SpawnResult != 0)
+	{
+		GITCENTRAL_ERROR(TEXT("Failed to launch '%s' (error %d)"), *InPathToGitBinary, SpawnResult);
+		close(StdInWriteParent);
+		close(StdOutReadParent);
+		close(StdErrReadParent);
+		return false;
+	}
+
+	ProcessId = ChildId;
+	StdOutRead = StdOutReadParent;
+	StdErrRead = StdErrReadParent;
+	StdInWrite = StdInWriteParent;
+	bRunning = true;
+
+	if(!bInWithStdIn)
+	{
+		CloseStdIn();
+	}
+
+	return true;
+}
+
+bool FGitProcess::IsValid() const
+{
+	return ProcessId > 0;
+}
+
+bool FGitProcess::IsRunning()
+{
+	if(!bRunning)
+	{
+		return false;
+	}
+
+	int32 Status = 0;
+	const pid_t Result = waitpid(ProcessId, &Status, WNOHANG);
+	if(Result == 0)
+	{
+		return true;
+	}
+
+	if(Result == ProcessId)
+	{
+		ReturnCode = WIFEXITED(Status) ? WEXITSTATUS(Status) : -1;
+	}
+	bRunning = false;
+	return false;
+}
+
+static int32 ReadAvailable(int32 InFd, TArray<uint8>& OutData)
+{
+	if(InFd < 0)
+	{
+		return 0;
+	}
+
+	int32 TotalRead = 0;
+	for(;;)
+	{
+		const int32 Offset = OutData.AddUninitialized(GitProcessConstants::ReadChunkSize);
+		const ssize_t BytesRead = read(InFd, OutData.GetData() + Offset, GitProcessConstants::ReadChunkSize);
+		if(BytesRead > 0)
+		{
+			OutData.SetNum(Offset + BytesRead, false);
+			TotalRead += BytesRead;
+		}
+		else
+		{
+			OutData.SetNum(Offset, false);
+			if(BytesRead < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			// EAGAIN: nothing more for now, 0: end of file
+			break;
+		}
+	}
+	return TotalRead;
+}
+
+int32 FGitProcess::ReadStdOut(TArray<uint8>& OutData)
+{
+	return ReadAvailable(StdOutRead, OutData);
+}
+
+int32 FGitProcess::ReadStdErr(TArray<uint8>& OutData)
+{
+	return ReadAvailable(StdErrRead, OutData);
+}
+
+bool FGitProcess::WriteStdIn(const uint8* InData, int32 InSize)
+{
+	if(StdInWrite < 0)
+	{
+		return false;
+	}
+
+	while(InSize > 0)
+	{
+		const ssize_t BytesWritten = write(StdInWrite, InData, InSize);
+		if(BytesWritten < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		InData += BytesWritten;
+		InSize -= BytesWritten;
+	}
+	return true;
+}
+
+void FGitProcess::CloseStdIn()
+{
+	if(StdInWrite >= 0)
+	{
+		close(StdInWrite);
+		StdInWrite = -1;
+	}
+}
+
+void FGitProcess::Terminate()
+{
+	if(IsRunning())
+	{
+		// The child is the leader of its own process group
+		kill(-ProcessId, SIGKILL);
+		kill(ProcessId, SIGKILL);
+
+		int32 Status = 0;
+		waitpid(ProcessId, &Status, 0);
+		bRunning = false;
+		ReturnCode = -1;
+	}
+}
+
+void FGitProcess::ReleaseHandles()
+{
+	CloseStdIn();
+	if(StdOutRead >= 0)
+	{
+		close(StdOutRead);
+		StdOutRead = -1;
+	}
+	if(StdErrRead >= 0)
+	{
+		close(StdErrRead);
+		StdErrRead = -1;
+	}
+	ProcessId = -1;
+}
+
+#endif // PLATFORM_WINDOWS
+
+void FGitProcess::Close()
+{
+	if(!IsValid())
+	{
+		return;
+	}
+
+	CloseStdIn();
+
+	// Give the process a chance to exit by itself, it may be blocked writing to a full pipe so keep draining it
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<uint8> Discarded;
+	int32 IdleIterations = 0;
+	while(IsRunning() && FPlatformTime::Seconds() - StartTime < GitProcessConstants::CloseTimeout)
+	{
+		Discarded.Reset();
+		if(ReadStdOut(Discarded) + ReadStdErr(Discarded) == 0)
+		{
+			WaitBackOff(IdleIterations);
+		}
+	}
+
+	Terminate();
+	ReleaseHandles();
+}
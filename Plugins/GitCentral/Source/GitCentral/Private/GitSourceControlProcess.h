@@ -0,0 +1,95 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * A git child process with its own stdin, stdout and stderr pipes.
+ *
+ * FPlatformProcess::CreateProc redirects stdout and stderr to the same pipe, which makes machine readable outputs unreliable,
+ * and FPlatformProcess::ExecProcess only returns once the process has exited.
+ * This spawns the process natively so that outputs can be consumed while the process is running, and input can be written to it.
+ * Reads are non-blocking, writes are blocking.
+ */
+class FGitProcess
+{
+public:
+	FGitProcess();
+	~FGitProcess();
+
+	/**
+	 * Start the process
+	 * @param	InPathToGitBinary	The path to the Git binary
+	 * @param	InParams			The full command line, arguments containing spaces must be quoted
+	 * @param	bInWithStdIn		If true, stdin is a pipe that can be written to with WriteStdIn, otherwise stdin is closed
+	 * @returns true if the process was started
+	 */
+	bool Launch(const FString& InPathToGitBinary, const FString& InParams, bool bInWithStdIn = false);
+
+	/** @returns true if the process was started and has not been closed yet */
+	bool IsValid() const;
+
+	/** @returns true if the process has not exited yet */
+	bool IsRunning();
+
+	/**
+	 * Append all the data currently available on stdout, without blocking
+	 * @returns the number of bytes read
+	 */
+	int32 ReadStdOut(TArray<uint8>& OutData);
+
+	/**
+	 * Append all the data currently available on stderr, without blocking
+	 * @returns the number of bytes read
+	 */
+	int32 ReadStdErr(TArray<uint8>& OutData);
+
+	/**
+	 * Write data to the stdin of the process, blocks until everything is written
+	 * @returns false if the pipe is broken or stdin was not requested
+	 */
+	bool WriteStdIn(const uint8* InData, int32 InSize);
+
+	/** Write a line to stdin, the line terminator is added */
+	bool WriteStdInLine(const FString& InLine);
+
+	/** Close stdin so the process receives end of file */
+	void CloseStdIn();
+
+	/** Kill the process and all of its children */
+	void Terminate();
+
+	/** @returns the exit code of the process, only valid once it is no longer running */
+	int32 GetReturnCode() const
+	{
+		return ReturnCode;
+	}
+
+	/** Close stdin, wait for the process to exit for a short while, terminate it otherwise and release all handles */
+	void Close();
+
+	/** Sleep strategy for polling loops: yields for the first iterations then sleeps for a short time */
+	static void WaitBackOff(int32& InOutIdleIterations);
+
+private:
+	void ReleaseHandles();
+
+	/** The exit code of the process, -1 until it has exited */
+	int32 ReturnCode;
+
+	/** Whether we still need to reap the process */
+	bool bRunning;
+
+#if PLATFORM_WINDOWS
+	void* ProcessHandle;
+	void* StdInWrite;
+	void* StdOutRead;
+	void* StdErrRead;
+#else
+	int32 ProcessId;
+	int32 StdInWrite;
+	int32 StdOutRead;
+	int32 StdErrRead;
+#endif
+};
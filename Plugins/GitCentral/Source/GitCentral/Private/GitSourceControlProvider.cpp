@@ -125,6 +125,15 @@ bool FGitSourceControlProvider::CheckGitAvailability()
 		bGitAvailable = false;
 	}
 
+	if(bGitAvailable && bGitRepositoryFound)
+	{
+		DirtyPathTracker.Start(PathToRepositoryRoot);
+	}
+	else
+	{
+		DirtyPathTracker.Stop();
+	}
+
 	if(PathToRepositoryRoot != OldRepositoryRootPath || bWasGitAvailable != bGitAvailable)
 	{
 		GITCENTRAL_LOG(TEXT("GitCentral status: git found? %s, repository: %s, reloaded cache file")
@@ -136,33 +145,25 @@ bool FGitSourceControlProvider::CheckGitAvailability()
 
 void FGitSourceControlProvider::ClearCache()
 {
-	StateCache.Empty();
+	StateStore.Empty();
 	bForceBroadcastUpdateNextTick = true;
 }
 
 void FGitSourceControlProvider::Close()
 {
 	ClearCache();
+	PendingRefreshFiles.Empty();
+	Scheduler.Shutdown();
+	FetchScheduler.Reset();
+	CatFileBatch.Shutdown();
+	DirtyPathTracker.Stop();
+	RemoteDiffCache.Invalidate();
+	LockCache.Invalidate();
+	CommitGraph.Reset();
+	Index.Reset();
 	FGitSourceControlModule::GetInstance().UnregisterMenuExtensions();
 }
 
-TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlProvider::GetStateInternal(const FString& Filename)
-{
-	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* State = StateCache.Find(Filename);
-	if(State != NULL)
-	{
-		// found cached item
-		return (*State);
-	}
-	else
-	{
-		// cache an unknown state for this item
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> NewState = MakeShared<FGitSourceControlState, ESPMode::ThreadSafe>(Filename);
-		StateCache.Add(Filename, NewState);
-		return NewState;
-	}
-}
-
 FText FGitSourceControlProvider::GetStatusText() const
 {
 	FFormatNamedArguments Args;
@@ -204,34 +205,89 @@ ECommandResult::Type FGitSourceControlProvider::GetState( const TArray<FString>&
 	//Note that alike the other source control providers, if the state is not in cache it will not attept to fetch it
 	if(InStateCacheUsage == EStateCacheUsage::ForceUpdate)
 	{
-		Execute(ISourceControlOperation::Create<FUpdateStatus>(), AbsoluteFiles);
+		//Note: callers which need the up to date state, like pre-submit validation, can still Execute FUpdateStatus synchronously
+		if(FGitSourceControlModule::GetInstance().AccessSettings().IsBackgroundForceUpdate() && IsInGameThread())
+		{
+			RequestBackgroundRefresh(AbsoluteFiles);
+		}
+		else
+		{
+			Execute(ISourceControlOperation::Create<FUpdateStatus>(), AbsoluteFiles);
+		}
+	}
+
+	StateStore.GetStates(AbsoluteFiles, OutState);
+
+	return ECommandResult::Succeeded;
+}
+
+void FGitSourceControlProvider::RequestBackgroundRefresh(const TArray<FString>& InFiles)
+{
+	//Note: an update without files would scan the whole repository
+	if(InFiles.Num() == 0)
+	{
+		return;
 	}
 
-	for(const auto& AbsoluteFile : AbsoluteFiles)
+	PendingRefreshFiles.Append(InFiles);
+	if(!bBackgroundRefreshInProgress)
 	{
-		OutState.Add(GetStateInternal(*AbsoluteFile));
+		IssueBackgroundRefresh();
 	}
+}
 
-	return ECommandResult::Succeeded;
+void FGitSourceControlProvider::IssueBackgroundRefresh()
+{
+	TArray<FString> Files = PendingRefreshFiles.Array();
+	PendingRefreshFiles.Empty();
+
+	bBackgroundRefreshInProgress = true;
+	const ECommandResult::Type Result = Execute(ISourceControlOperation::Create<FUpdateStatus>(), Files, EConcurrency::Asynchronous,
+		FSourceControlOperationComplete::CreateRaw(this, &FGitSourceControlProvider::OnBackgroundRefreshComplete));
+	if(Result != ECommandResult::Succeeded)
+	{
+		bBackgroundRefreshInProgress = false;
+	}
+}
+
+void FGitSourceControlProvider::OnBackgroundRefreshComplete(const FSourceControlOperationRef& InOperation, ECommandResult::Type InResult)
+{
+	//Note: the states changed by the refresh are broadcast by Tick, the files requested in the meantime are refreshed together
+	bBackgroundRefreshInProgress = false;
+	if(PendingRefreshFiles.Num() > 0)
+	{
+		IssueBackgroundRefresh();
+	}
 }
 
 TArray<FSourceControlStateRef> FGitSourceControlProvider::GetCachedStateByPredicate(TFunctionRef<bool(const FSourceControlStateRef&)> Predicate) const
 {
 	TArray<FSourceControlStateRef> Result;
-	for(const auto& CacheItem : StateCache)
+	StateStore.ForEachState([&Predicate, &Result](const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>& InState)
 	{
-		FSourceControlStateRef State = CacheItem.Value;
+		FSourceControlStateRef State = InState;
 		if(Predicate(State))
 		{
 			Result.Add(State);
 		}
-	}
+	});
 	return Result;
 }
 
 bool FGitSourceControlProvider::RemoveFileFromCache(const FString& Filename)
 {
-	return StateCache.Remove(Filename) > 0;
+	return StateStore.Remove(Filename);
+}
+
+void FGitSourceControlProvider::AddChangedFiles(const TArray<FString>& InFiles)
+{
+	PendingChangedFiles.Append(InFiles);
+}
+
+bool FGitSourceControlProvider::GetChangedFiles(TArray<FString>& OutFiles) const
+{
+	OutFiles = BroadcastChangedFiles;
+	return !bBroadcastAllStatesChanged;
 }
 
 FDelegateHandle FGitSourceControlProvider::RegisterSourceControlStateChanged_Handle( const FSourceControlStateChanged::FDelegate& SourceControlStateChanged )
@@ -290,17 +346,41 @@ ECommandResult::Type FGitSourceControlProvider::Execute( const TSharedRef<ISourc
 	else
 	{
 		Command->bAutoDelete = true;
+
+		//Note: only asynchronous requests are merged, a synchronous caller expects its own up to date result
+		Command->bCanCoalesce = InOperation->GetName() == FName("UpdateStatus");
+		if(Command->bCanCoalesce && !UpdateStatusCoalescer.Issue(*Command))
+		{
+			delete Command;
+			return ECommandResult::Succeeded;
+		}
+
 		return IssueCommand(*Command);
 	}
 }
 
 bool FGitSourceControlProvider::CanCancelOperation( const TSharedRef<ISourceControlOperation, ESPMode::ThreadSafe>& InOperation ) const
 {
+	for(const FGitSourceControlCommand* Command : CommandQueue)
+	{
+		if(Command->Operation == InOperation && !Command->bExecuteProcessed)
+		{
+			return true;
+		}
+	}
 	return false;
 }
 
 void FGitSourceControlProvider::CancelOperation( const TSharedRef<ISourceControlOperation, ESPMode::ThreadSafe>& InOperation )
 {
+	for(FGitSourceControlCommand* Command : CommandQueue)
+	{
+		if(Command->Operation == InOperation)
+		{
+			GITCENTRAL_LOG(TEXT("Cancelling %s"), *InOperation->GetName().ToString());
+			Command->Cancel();
+		}
+	}
 }
 
 bool FGitSourceControlProvider::UsesLocalReadOnlyState() const
@@ -359,6 +439,17 @@ void FGitSourceControlProvider::Tick()
 		{
 			// Remove command from the queue
 			CommandQueue.RemoveAt(CommandIndex);
+			Scheduler.Release(Command);
+
+			// a coalesced command did not run, its requests are reported by the command which covered it
+			if(Command.bCoalesced)
+			{
+				if(Command.bAutoDelete)
+				{
+					delete &Command;
+				}
+				break;
+			}
 
 			// let command update the states of any files
 			bStatesUpdated |= Command.Worker->UpdateStates();
@@ -370,11 +461,15 @@ void FGitSourceControlProvider::Tick()
 			OutputCommandMessages(Command);
 
 			// run the completion delegate callback if we have one bound
-			ECommandResult::Type Result = Command.bCommandSuccessful ? ECommandResult::Succeeded : ECommandResult::Failed;
+			ECommandResult::Type Result = GetCommandResult(Command);
 
 			GITCENTRAL_VERBOSE(TEXT("FGitSourceControlProvider::CommandFinished: %s, Success: %s"), *Command.Operation->GetName().ToString(), Command.bCommandSuccessful ? TEXT("true") : TEXT("false"));
 
 			Command.OperationCompleteDelegate.ExecuteIfBound(Command.Operation, Result);
+			for(const auto& MergedRequest : Command.MergedRequests)
+			{
+				MergedRequest.Value.ExecuteIfBound(MergedRequest.Key, Result);
+			}
 
 			// commands that are left in the array during a tick need to be deleted
 			if(Command.bAutoDelete)
@@ -389,10 +484,24 @@ void FGitSourceControlProvider::Tick()
 		}
 	}
 
+	if(bConnected && IsEnabled())
+	{
+		FetchScheduler.Tick(*this);
+	}
+
 	if(bStatesUpdated || bForceBroadcastUpdateNextTick)
 	{
+		//Note: a command may update states without reporting which ones, every state may have changed then
+		bBroadcastAllStatesChanged = bForceBroadcastUpdateNextTick || PendingChangedFiles.Num() == 0;
+		BroadcastChangedFiles = PendingChangedFiles.Array();
+		PendingChangedFiles.Reset();
+
+		StatesChanged.Broadcast(BroadcastChangedFiles, bBroadcastAllStatesChanged);
 		OnSourceControlStateChanged.Broadcast();
 		bForceBroadcastUpdateNextTick = false;
+
+		BroadcastChangedFiles.Reset();
+		bBroadcastAllStatesChanged = false;
 	}
 }
 
@@ -429,10 +538,13 @@ ECommandResult::Type FGitSourceControlProvider::ExecuteSynchronousCommand(FGitSo
 
 	// Display the progress dialog if a string was provided
 	{
-		FScopedSourceControlProgress Progress(Task);
+		FScopedSourceControlProgress Progress(Task, FSimpleDelegate::CreateLambda([&InCommand]()
+		{
+			InCommand.Cancel();
+		}));
 
 		// Issue the command asynchronously...
-		IssueCommand( InCommand );
+		IssueCommand( InCommand, true );
 
 		// ... then wait for its completion (thus making it synchrounous)
 		while(!InCommand.bExecuteProcessed)
@@ -449,10 +561,7 @@ ECommandResult::Type FGitSourceControlProvider::ExecuteSynchronousCommand(FGitSo
 		// always do one more Tick() to make sure the command queue is cleaned up.
 		Tick();
 
-		if(InCommand.bCommandSuccessful)
-		{
-			Result = ECommandResult::Succeeded;
-		}
+		Result = GetCommandResult(InCommand);
 	}
 
 	// Delete the command now (asynchronous commands are deleted in the Tick() method)
@@ -463,23 +572,27 @@ ECommandResult::Type FGitSourceControlProvider::ExecuteSynchronousCommand(FGitSo
 	{
 		CommandQueue.Remove( &InCommand );
 	}
+	Scheduler.Release(InCommand);
 	delete &InCommand;
 
 	return Result;
 }
 
-ECommandResult::Type FGitSourceControlProvider::IssueCommand(FGitSourceControlCommand& InCommand)
+ECommandResult::Type FGitSourceControlProvider::GetCommandResult(const FGitSourceControlCommand& InCommand)
 {
-	if(GThreadPool != nullptr)
+	if(InCommand.bCommandSuccessful)
 	{
-		// Queue this to our worker thread(s) for resolving
-		GThreadPool->AddQueuedWork(&InCommand);
-		CommandQueue.Add(&InCommand);
 		return ECommandResult::Succeeded;
 	}
-	else
-	{
-		return ECommandResult::Failed;
-	}
+	return InCommand.WasCancelled() ? ECommandResult::Cancelled : ECommandResult::Failed;
+}
+
+ECommandResult::Type FGitSourceControlProvider::IssueCommand(FGitSourceControlCommand& InCommand, bool bInSynchronous)
+{
+	// Queue this to our worker thread(s) for resolving
+	InCommand.Concurrency = bInSynchronous ? EConcurrency::Synchronous : EConcurrency::Asynchronous;
+	CommandQueue.Add(&InCommand);
+	Scheduler.Enqueue(InCommand, bInSynchronous);
+	return ECommandResult::Succeeded;
 }
 #undef LOCTEXT_NAMESPACE
@@ -5,9 +5,23 @@
 #include "ISourceControlProvider.h"
 #include "IGitSourceControlWorker.h"
 #include "GitSourceControlState.h"
+#include "GitSourceControlCatFile.h"
+#include "GitSourceControlStats.h"
+#include "GitSourceControlDirtyPaths.h"
+#include "GitSourceControlRemoteDiffCache.h"
+#include "GitSourceControlLockCache.h"
+#include "GitSourceControlCommitGraph.h"
+#include "GitSourceControlIndex.h"
+#include "GitSourceControlStateStore.h"
+#include "GitSourceControlUpdateCoalescer.h"
+#include "GitSourceControlScheduler.h"
+#include "GitSourceControlFetch.h"
 
 DECLARE_DELEGATE_RetVal(FGitSourceControlWorkerRef, FGetGitSourceControlWorker)
 
+/** Files whose state changed, or bAllStatesChanged if every state may have changed (cache cleared, reconnection) */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FGitSourceControlStatesChanged, const TArray<FString>& /*ChangedFiles*/, bool /*bAllStatesChanged*/)
+
 class FGitSourceControlProvider : public ISourceControlProvider
 {
 public:
@@ -93,9 +107,30 @@ public:
 		return RemoteName;
 	}
 
-	/** Helper function used to update state cache */
-	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> GetStateInternal(const FString& Filename);
-	const TMap<FString, TSharedRef<class FGitSourceControlState, ESPMode::ThreadSafe>>& GetAllStatesInternal() { return StateCache; }
+	/** Record of the fetches and scheduler of the background fetches, safe to use from worker threads */
+	FGitFetchScheduler& GetFetchScheduler() { return FetchScheduler; }
+
+	/** Threads running the commands, safe to use from worker threads */
+	FGitCommandScheduler& GetScheduler() { return Scheduler; }
+
+	/** Merges redundant UpdateStatus commands, safe to use from worker threads */
+	FGitUpdateStatusCoalescer& GetUpdateStatusCoalescer() { return UpdateStatusCoalescer; }
+
+	/** Record files whose cached state changed, reported to the listeners on next Tick */
+	void AddChangedFiles(const TArray<FString>& InFiles);
+
+	/**
+	 * Files whose state changed, only valid while OnSourceControlStateChanged is broadcast.
+	 * Lets the listeners of the engine delegate refresh the affected items only.
+	 * @returns false if every state may have changed
+	 */
+	bool GetChangedFiles(TArray<FString>& OutFiles) const;
+
+	/** Broadcast before OnSourceControlStateChanged, with the files whose state changed */
+	FGitSourceControlStatesChanged& OnStatesChanged() { return StatesChanged; }
+
+	/** Cache of the states of the files, safe to use from worker threads */
+	FGitStateStore& GetStateStore() { return StateStore; }
 
 	/**
 	 * Register a worker with the provider.
@@ -110,6 +145,27 @@ public:
 	void SetLastSyncOperationUpdatedFiles(const TArray<FString>& Files) { LastSyncOperationUpdatedFiles = Files; }
 	const TArray<FString>& GetLastSyncOperationUpdatedFiles() const { return LastSyncOperationUpdatedFiles; }
 
+	/** Persistent git cat-file processes used for object lookups, safe to use from worker threads */
+	FGitCatFileBatch& GetCatFileBatch() { return CatFileBatch; }
+
+	/** Timings of the git processes launched by the plugin, safe to use from worker threads */
+	FGitCommandStats& GetCommandStats() { return CommandStats; }
+
+	/** Paths changed on disk since the last status refresh, safe to use from worker threads */
+	FGitDirtyPathTracker& GetDirtyPathTracker() { return DirtyPathTracker; }
+
+	/** Changes of the remote branch since the merge-base, safe to use from worker threads */
+	FGitRemoteDiffCache& GetRemoteDiffCache() { return RemoteDiffCache; }
+
+	/** Locks last queried from the LFS server, safe to use from worker threads */
+	FGitLockCache& GetLockCache() { return LockCache; }
+
+	/** Index of the commit history for merge-base and ancestry queries, safe to use from worker threads */
+	FGitCommitGraph& GetCommitGraph() { return CommitGraph; }
+
+	/** Parsed git index, to skip git status for unchanged files, safe to use from worker threads */
+	FGitIndex& GetIndex() { return Index; }
+
 private:
 
 	/** Is git binary found and working. */
@@ -129,8 +185,16 @@ private:
 
 	/** Helper function for running command synchronously. */
 	ECommandResult::Type ExecuteSynchronousCommand(class FGitSourceControlCommand& InCommand, const FText& Task);
-	/** Issue a command asynchronously if possible. */
-	ECommandResult::Type IssueCommand(class FGitSourceControlCommand& InCommand);
+	/** Result reported for a finished command: Cancelled if it failed after cancellation was requested */
+	static ECommandResult::Type GetCommandResult(const class FGitSourceControlCommand& InCommand);
+
+	/** Issue a command asynchronously, bInSynchronous if the game thread waits for it */
+	ECommandResult::Type IssueCommand(class FGitSourceControlCommand& InCommand, bool bInSynchronous = false);
+
+	/** Refresh the status of files asynchronously, batching the files requested while a refresh is running */
+	void RequestBackgroundRefresh(const TArray<FString>& InFiles);
+	void IssueBackgroundRefresh();
+	void OnBackgroundRefreshComplete(const FSourceControlOperationRef& InOperation, ECommandResult::Type InResult);
 
 	/** Output any messages this command holds */
 	void OutputCommandMessages(const class FGitSourceControlCommand& InCommand) const;
@@ -151,7 +215,22 @@ private:
 	FString RemoteName;
 
 	/** State cache */
-	TMap<FString, TSharedRef<class FGitSourceControlState, ESPMode::ThreadSafe> > StateCache;
+	FGitStateStore StateStore;
+
+	/** Merges redundant UpdateStatus commands */
+	FGitUpdateStatusCoalescer UpdateStatusCoalescer;
+
+	/** Threads running the commands */
+	FGitCommandScheduler Scheduler;
+
+	/** Background fetches of the remote branch */
+	FGitFetchScheduler FetchScheduler;
+
+	/** Files waiting for the next background refresh */
+	TSet<FString> PendingRefreshFiles;
+
+	/** Whether a background refresh is running */
+	bool bBackgroundRefreshInProgress = false;
 
 	/** The currently registered source control operations */
 	TMap<FName, FGetGitSourceControlWorker> WorkersMap;
@@ -162,5 +241,36 @@ private:
 	/** For notifying when the source control states in the cache have changed */
 	FSourceControlStateChanged OnSourceControlStateChanged;
 
+	/** For notifying which source control states in the cache have changed */
+	FGitSourceControlStatesChanged StatesChanged;
+
+	/** Files whose state changed since the last broadcast */
+	TSet<FString> PendingChangedFiles;
+
+	/** Files whose state changed, while the change is broadcast */
+	TArray<FString> BroadcastChangedFiles;
+	bool bBroadcastAllStatesChanged = false;
+
 	TArray<FString> LastSyncOperationUpdatedFiles;
+
+	/** Persistent git cat-file processes */
+	FGitCatFileBatch CatFileBatch;
+
+	/** Aggregated timings of git processes */
+	FGitCommandStats CommandStats;
+
+	/** Watches the working copy to refresh the status of changed paths only */
+	FGitDirtyPathTracker DirtyPathTracker;
+
+	/** Last diff between the merge-base and the remote branch */
+	FGitRemoteDiffCache RemoteDiffCache;
+
+	/** Last lfs locks of the repository */
+	FGitLockCache LockCache;
+
+	/** Commit history of the repository */
+	FGitCommitGraph CommitGraph;
+
+	/** Index of the repository */
+	FGitIndex Index;
 };
@@ -0,0 +1,55 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlRemoteDiffCache.h"
+#include "Misc/ScopeLock.h"
+
+FGitStateMapPtr FGitRemoteDiffCache::Find(const FString& InRepositoryRoot, const FString& InMergeBase, const FString& InRemoteSha) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	if(States.IsValid() && InRepositoryRoot == RepositoryRoot && InMergeBase == MergeBase && InRemoteSha == RemoteSha)
+	{
+		return States;
+	}
+	return nullptr;
+}
+
+FGitStateMapPtr FGitRemoteDiffCache::FindForMergeBase(const FString& InRepositoryRoot, const FString& InMergeBase, FString& OutRemoteSha) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	if(States.IsValid() && InRepositoryRoot == RepositoryRoot && InMergeBase == MergeBase)
+	{
+		OutRemoteSha = RemoteSha;
+		return States;
+	}
+	return nullptr;
+}
+
+void FGitRemoteDiffCache::Add(const FString& InRepositoryRoot, const FString& InMergeBase, const FString& InRemoteSha, FGitStateMapPtr InStates)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	RepositoryRoot = InRepositoryRoot;
+	MergeBase = InMergeBase;
+	RemoteSha = InRemoteSha;
+	States = MoveTemp(InStates);
+}
+
+void FGitRemoteDiffCache::Invalidate()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	States.Reset();
+}
+
+bool FGitRemoteDiffCache::Extend(const FGitStateMap& InFirst, const FGitStateMap& InSecond, FGitStateMap& OutResult)
+{
+	for(const auto& It : InSecond)
+	{
+		if(InFirst.Contains(It.Key))
+		{
+			return false;
+		}
+	}
+
+	OutResult = InFirst;
+	OutResult.Append(InSecond);
+	return true;
+}
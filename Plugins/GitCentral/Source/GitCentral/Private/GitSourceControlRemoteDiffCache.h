@@ -0,0 +1,58 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "GitSourceControlState.h"
+
+typedef TMap<FString, FGitSourceControlState> FGitStateMap;
+typedef TSharedPtr<const FGitStateMap, ESPMode::ThreadSafe> FGitStateMapPtr;
+
+/**
+ * The changes between the merge-base of the local and remote branches and the remote branch, as parsed from diff --name-status.
+ * Both commits rarely move between two fetches, so the diff is kept across commands instead of being recomputed on each status update.
+ * When only the remote branch moved forward, the cached diff can be extended with the diff between the old and the new remote commit,
+ * as long as the new commits change other files.
+ * Thread safe, the diff is shared and never modified once cached.
+ */
+class FGitRemoteDiffCache
+{
+public:
+	/**
+	 * Find the diff from a merge-base to a remote commit
+	 * @returns the cached diff, null if not cached
+	 */
+	FGitStateMapPtr Find(const FString& InRepositoryRoot, const FString& InMergeBase, const FString& InRemoteSha) const;
+
+	/**
+	 * Find a diff from the same merge-base to an older remote commit, which can be extended up to the new remote commit
+	 * @param	OutRemoteSha	The remote commit of the cached diff
+	 * @returns the cached diff, null if there is none for this merge-base
+	 */
+	FGitStateMapPtr FindForMergeBase(const FString& InRepositoryRoot, const FString& InMergeBase, FString& OutRemoteSha) const;
+
+	/** Cache the diff from a merge-base to a remote commit, replacing the previous one */
+	void Add(const FString& InRepositoryRoot, const FString& InMergeBase, const FString& InRemoteSha, FGitStateMapPtr InStates);
+
+	/** Forget the cached diff */
+	void Invalidate();
+
+	/**
+	 * Extend a diff from A to B with the diff from B to C, into the diff from A to C.
+	 * Two changes of the same file cannot be composed: it may have been changed back to its content in A, which name-status does not tell.
+	 * @param	InFirst		Changes from A to B
+	 * @param	InSecond	Changes from B to C
+	 * @param	OutResult	The changes from A to C
+	 * @returns false if a file changed in both diffs, the diff from A to C must then be computed
+	 */
+	static bool Extend(const FGitStateMap& InFirst, const FGitStateMap& InSecond, FGitStateMap& OutResult);
+
+private:
+	mutable FCriticalSection CriticalSection;
+
+	FString RepositoryRoot;
+	FString MergeBase;
+	FString RemoteSha;
+	FGitStateMapPtr States;
+};
@@ -0,0 +1,209 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlScheduler.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlCommand.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformTime.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("GitCentral"), STATGROUP_GitCentral, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Queued Commands"), STAT_GitCentral_QueuedCommands, STATGROUP_GitCentral);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Running Commands"), STAT_GitCentral_RunningCommands, STATGROUP_GitCentral);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last Queue Wait (ms)"), STAT_GitCentral_LastQueueWait, STATGROUP_GitCentral);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Max Queue Wait (ms)"), STAT_GitCentral_MaxQueueWait, STATGROUP_GitCentral);
+
+namespace GitSchedulerConstants
+{
+	/** Number of threads, the maximum number of read-only commands running at the same time */
+	static const int32 NumThreads = 4;
+
+	/** Stack size of the threads, commands parse large git outputs */
+	static const uint32 StackSize = 256 * 1024;
+}
+
+/** Runs a command on a thread of the scheduler, and tells the scheduler when it is done */
+class FGitCommandScheduler::FScheduledWork : public IQueuedWork
+{
+public:
+	FScheduledWork(FGitCommandScheduler& InScheduler, FGitSourceControlCommand& InCommand, bool bInReadOnly)
+		: Scheduler(InScheduler)
+		, Command(InCommand)
+		, bReadOnly(bInReadOnly)
+	{
+	}
+
+	virtual void DoThreadedWork() override
+	{
+		//Note: the game thread may delete the command as soon as it is processed, it must not be used afterwards
+		Command.DoThreadedWork();
+		Finish();
+	}
+
+	virtual void Abandon() override
+	{
+		Command.Abandon();
+		Finish();
+	}
+
+private:
+	void Finish()
+	{
+		Scheduler.OnFinished(bReadOnly);
+		delete this;
+	}
+
+	FGitCommandScheduler& Scheduler;
+	FGitSourceControlCommand& Command;
+	bool bReadOnly;
+};
+
+FGitCommandScheduler::~FGitCommandScheduler()
+{
+	Shutdown();
+}
+
+void FGitCommandScheduler::Enqueue(FGitSourceControlCommand& InCommand, bool bInSynchronous)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(ThreadPool == nullptr)
+	{
+		ThreadPool = FQueuedThreadPool::Allocate();
+		verify(ThreadPool->Create(GitSchedulerConstants::NumThreads, GitSchedulerConstants::StackSize, TPri_Normal, TEXT("GitCentral")));
+	}
+
+	FQueuedCommand QueuedCommand;
+	QueuedCommand.Command = &InCommand;
+	QueuedCommand.Priority = bInSynchronous ? EGitCommandPriority::Interactive : InCommand.Worker->GetPriority();
+	QueuedCommand.bReadOnly = InCommand.Worker->IsReadOnly();
+	QueuedCommand.EnqueueTime = FPlatformTime::Seconds();
+
+	int32 Index = 0;
+	while(Index < Queue.Num() && Queue[Index].Priority >= QueuedCommand.Priority)
+	{
+		Index++;
+	}
+	Queue.Insert(QueuedCommand, Index);
+	MaxQueueDepth = FMath::Max(MaxQueueDepth, Queue.Num());
+
+	Dispatch();
+}
+
+void FGitCommandScheduler::Release(FGitSourceControlCommand& InCommand)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	RunningCommands.RemoveSingleSwap(&InCommand);
+}
+
+void FGitCommandScheduler::Shutdown()
+{
+	TArray<FQueuedCommand> AbandonedCommands;
+	FQueuedThreadPool* Pool = nullptr;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		AbandonedCommands = MoveTemp(Queue);
+		Queue.Reset();
+		Pool = ThreadPool;
+		ThreadPool = nullptr;
+		UpdateQueueStats();
+
+		//Note: terminates their git processes, so that closing the provider does not wait for a long fetch or status to complete
+		for(FGitSourceControlCommand* Command : RunningCommands)
+		{
+			Command->Cancel();
+		}
+	}
+
+	for(const FQueuedCommand& QueuedCommand : AbandonedCommands)
+	{
+		QueuedCommand.Command->Abandon();
+	}
+
+	//Note: waits for the running commands, which cannot start anything else as the pool is no longer known
+	if(Pool != nullptr)
+	{
+		Pool->Destroy();
+		delete Pool;
+	}
+}
+
+void FGitCommandScheduler::Dispatch()
+{
+	//Note: the queue is strictly ordered, a command modifying the repository blocks the reads queued after it instead of waiting forever
+	while(ThreadPool != nullptr && Queue.Num() > 0)
+	{
+		const FQueuedCommand& Next = Queue[0];
+		const bool bCanStart = Next.bReadOnly
+			? !bWriteRunning && NumRunningReads < GitSchedulerConstants::NumThreads
+			: !bWriteRunning && NumRunningReads == 0;
+		if(!bCanStart)
+		{
+			break;
+		}
+
+		if(Next.bReadOnly)
+		{
+			NumRunningReads++;
+		}
+		else
+		{
+			bWriteRunning = true;
+		}
+
+		const double WaitSeconds = FPlatformTime::Seconds() - Next.EnqueueTime;
+		NumStarted++;
+		TotalWaitSeconds += WaitSeconds;
+		MaxWaitSeconds = FMath::Max(MaxWaitSeconds, WaitSeconds);
+		SET_FLOAT_STAT(STAT_GitCentral_LastQueueWait, WaitSeconds * 1000.0);
+		SET_FLOAT_STAT(STAT_GitCentral_MaxQueueWait, MaxWaitSeconds * 1000.0);
+
+		FScheduledWork* Work = new FScheduledWork(*this, *Next.Command, Next.bReadOnly);
+		RunningCommands.Add(Next.Command);
+		Queue.RemoveAt(0);
+		ThreadPool->AddQueuedWork(Work);
+	}
+
+	UpdateQueueStats();
+}
+
+void FGitCommandScheduler::OnFinished(bool bInReadOnly)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	if(bInReadOnly)
+	{
+		NumRunningReads--;
+	}
+	else
+	{
+		bWriteRunning = false;
+	}
+
+	Dispatch();
+}
+
+void FGitCommandScheduler::UpdateQueueStats() const
+{
+	SET_DWORD_STAT(STAT_GitCentral_QueuedCommands, Queue.Num());
+	SET_DWORD_STAT(STAT_GitCentral_RunningCommands, NumRunningReads + (bWriteRunning ? 1 : 0));
+}
+
+void FGitCommandScheduler::PrintStats() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	GITCENTRAL_LOG(TEXT("Git command queue: %d queued, %d running, max depth %d"), Queue.Num(), NumRunningReads + (bWriteRunning ? 1 : 0), MaxQueueDepth);
+	GITCENTRAL_LOG(TEXT("  %lld started, wait avg %.1fms max %.1fms"), NumStarted, NumStarted > 0 ? TotalWaitSeconds * 1000.0 / NumStarted : 0.0, MaxWaitSeconds * 1000.0);
+}
+
+void FGitCommandScheduler::ResetStats()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	NumStarted = 0;
+	TotalWaitSeconds = 0.0;
+	MaxWaitSeconds = 0.0;
+	MaxQueueDepth = Queue.Num();
+}
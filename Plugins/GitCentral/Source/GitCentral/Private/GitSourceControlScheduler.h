@@ -0,0 +1,81 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "IGitSourceControlWorker.h"
+
+class FGitSourceControlCommand;
+class FQueuedThreadPool;
+
+/**
+ * Runs the commands of the provider on threads of its own, instead of competing with the rest of the editor in GThreadPool.
+ * Read-only commands run concurrently, commands modifying the repository run alone, and the queue is ordered by priority:
+ * interactive operations run before background refreshes, then in the order they were issued.
+ * Queue depth and wait times are published in the GitCentral stat group and printed by gitcentral.PrintStats.
+ * Thread safe.
+ */
+class FGitCommandScheduler
+{
+public:
+	~FGitCommandScheduler();
+
+	/**
+	 * Queue a command, it is run as soon as its priority and the running commands allow it
+	 * @param	bInSynchronous	Whether the game thread waits for the command, making it interactive
+	 */
+	void Enqueue(FGitSourceControlCommand& InCommand, bool bInSynchronous);
+
+	/** Forget a processed command, before it is deleted: it is no longer cancelled by Shutdown() */
+	void Release(FGitSourceControlCommand& InCommand);
+
+	/** Abandon the queued commands, cancel the running ones and wait for them. The threads are created again on next use */
+	void Shutdown();
+
+	/** Print the queue stats to the log */
+	void PrintStats() const;
+
+	/** Forget the queue stats */
+	void ResetStats();
+
+private:
+	struct FQueuedCommand
+	{
+		FGitSourceControlCommand* Command;
+		EGitCommandPriority::Type Priority;
+		bool bReadOnly;
+		double EnqueueTime;
+	};
+
+	class FScheduledWork;
+
+	/** Start the queued commands allowed to run, with CriticalSection held */
+	void Dispatch();
+
+	/** Called by a work when its command finished */
+	void OnFinished(bool bInReadOnly);
+
+	/** Publish the queue depth, with CriticalSection held */
+	void UpdateQueueStats() const;
+
+	mutable FCriticalSection CriticalSection;
+
+	/** Threads of the scheduler, created on first use */
+	FQueuedThreadPool* ThreadPool = nullptr;
+
+	/** Commands waiting to run, by decreasing priority then in order of issue */
+	TArray<FQueuedCommand> Queue;
+
+	/** Commands started and not released yet, some may have finished */
+	TArray<FGitSourceControlCommand*> RunningCommands;
+
+	int32 NumRunningReads = 0;
+	bool bWriteRunning = false;
+
+	/** Wait times of the commands started, since the last reset */
+	int64 NumStarted = 0;
+	double TotalWaitSeconds = 0.0;
+	double MaxWaitSeconds = 0.0;
+	int32 MaxQueueDepth = 0;
+};
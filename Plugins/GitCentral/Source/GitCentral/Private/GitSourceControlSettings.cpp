@@ -12,6 +12,9 @@ namespace GitSettingsConstants
 /** The section of the ini file we load our settings from */
 static const FString SettingsSection = TEXT("GitCentral.Settings");
 
+/** Subcommand key of the default timeout in the CommandTimeouts array */
+static const FString DefaultTimeoutKey = TEXT("*");
+
 }
 
 const FString& FGitSourceControlSettings::GetBinaryPath() const
@@ -103,6 +106,113 @@ bool FGitSourceControlSettings::IsAdmin() const
 	return bIsAdmin;
 }
 
+void FGitSourceControlSettings::SetAutoConfigureRepository(bool bInAutoConfigureRepository)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	bAutoConfigureRepository = bInAutoConfigureRepository;
+}
+
+bool FGitSourceControlSettings::IsAutoConfiguringRepository() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return bAutoConfigureRepository;
+}
+
+void FGitSourceControlSettings::SetMaxParallelGitProcesses(int32 InMaxParallelGitProcesses)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	MaxParallelGitProcesses = FMath::Max(1, InMaxParallelGitProcesses);
+}
+
+int32 FGitSourceControlSettings::GetMaxParallelGitProcesses() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return MaxParallelGitProcesses;
+}
+
+void FGitSourceControlSettings::SetFullStatusScanInterval(float InSeconds)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	FullStatusScanInterval = FMath::Max(0.f, InSeconds);
+}
+
+float FGitSourceControlSettings::GetFullStatusScanInterval() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return FullStatusScanInterval;
+}
+
+void FGitSourceControlSettings::SetBackgroundForceUpdate(bool bInBackgroundForceUpdate)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	bBackgroundForceUpdate = bInBackgroundForceUpdate;
+}
+
+bool FGitSourceControlSettings::IsBackgroundForceUpdate() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return bBackgroundForceUpdate;
+}
+
+void FGitSourceControlSettings::SetFetchInterval(float InSeconds)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	FetchInterval = FMath::Max(0.f, InSeconds);
+}
+
+float FGitSourceControlSettings::GetFetchInterval() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return FetchInterval;
+}
+
+void FGitSourceControlSettings::SetFetchIntervalJitter(float InSeconds)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	FetchIntervalJitter = FMath::Max(0.f, InSeconds);
+}
+
+float FGitSourceControlSettings::GetFetchIntervalJitter() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return FetchIntervalJitter;
+}
+
+void FGitSourceControlSettings::SetFetchStalenessBudget(float InSeconds)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	FetchStalenessBudget = FMath::Max(0.f, InSeconds);
+}
+
+float FGitSourceControlSettings::GetFetchStalenessBudget() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return FetchStalenessBudget;
+}
+
+float FGitSourceControlSettings::GetCommandTimeout(const FString& InSubCommand) const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const float* Timeout = CommandTimeouts.Find(InSubCommand);
+	return Timeout ? *Timeout : DefaultCommandTimeout;
+}
+
+void FGitSourceControlSettings::ResetCommandTimeouts()
+{
+	//Note: only commands which do not write the working tree or the index are killed (lfs smudge only writes to our pipe), a killed write
+	//could leave a half-applied tree or a stale index.lock. Transferring large binary files over a slow connection legitimately takes a long time
+	CommandTimeouts.Reset();
+	CommandTimeouts.Add(TEXT("fetch"), 1800.f);
+	CommandTimeouts.Add(TEXT("ls-remote"), 30.f);
+	CommandTimeouts.Add(TEXT("cat-file"), 60.f);
+	CommandTimeouts.Add(TEXT("lfs locks"), 60.f);
+	CommandTimeouts.Add(TEXT("lfs lock"), 60.f);
+	CommandTimeouts.Add(TEXT("lfs unlock"), 60.f);
+	CommandTimeouts.Add(TEXT("push"), 1800.f);
+	CommandTimeouts.Add(TEXT("lfs smudge"), 1800.f);
+	DefaultCommandTimeout = 0.f;
+}
+
 // This is called at startup nearly before anything else in our module: BinaryPath will then be used by the provider
 void FGitSourceControlSettings::LoadSettings()
 {
@@ -120,6 +230,41 @@ void FGitSourceControlSettings::LoadSettings()
 	bLoaded = GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("IsAdmin"), bIsAdmin, IniFile);
 	bLoaded = GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("UseLocking"), bUseLocking, IniFile);
 	bLoaded = GConfig->GetString(*GitSettingsConstants::SettingsSection, TEXT("LockingUsername"), LockingUsername, IniFile);
+	bLoaded = GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("AutoConfigureRepository"), bAutoConfigureRepository, IniFile);
+	bLoaded = GConfig->GetInt(*GitSettingsConstants::SettingsSection, TEXT("MaxParallelGitProcesses"), MaxParallelGitProcesses, IniFile);
+	MaxParallelGitProcesses = FMath::Max(1, MaxParallelGitProcesses);
+	bLoaded = GConfig->GetFloat(*GitSettingsConstants::SettingsSection, TEXT("FullStatusScanInterval"), FullStatusScanInterval, IniFile);
+	FullStatusScanInterval = FMath::Max(0.f, FullStatusScanInterval);
+	bLoaded = GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("BackgroundForceUpdate"), bBackgroundForceUpdate, IniFile);
+	bLoaded = GConfig->GetFloat(*GitSettingsConstants::SettingsSection, TEXT("FetchInterval"), FetchInterval, IniFile);
+	FetchInterval = FMath::Max(0.f, FetchInterval);
+	bLoaded = GConfig->GetFloat(*GitSettingsConstants::SettingsSection, TEXT("FetchIntervalJitter"), FetchIntervalJitter, IniFile);
+	FetchIntervalJitter = FMath::Max(0.f, FetchIntervalJitter);
+	bLoaded = GConfig->GetFloat(*GitSettingsConstants::SettingsSection, TEXT("FetchStalenessBudget"), FetchStalenessBudget, IniFile);
+	FetchStalenessBudget = FMath::Max(0.f, FetchStalenessBudget);
+
+	// Entries are "<subcommand>=<seconds>", "*=<seconds>" sets the default, 0 disables the timeout
+	ResetCommandTimeouts();
+	TArray<FString> TimeoutEntries;
+	GConfig->GetArray(*GitSettingsConstants::SettingsSection, TEXT("CommandTimeouts"), TimeoutEntries, IniFile);
+	for(const FString& Entry : TimeoutEntries)
+	{
+		FString SubCommand;
+		FString Seconds;
+		if(Entry.Split(TEXT("="), &SubCommand, &Seconds))
+		{
+			SubCommand.TrimStartAndEndInline();
+			const float Timeout = FMath::Max(0.f, FCString::Atof(*Seconds));
+			if(SubCommand == GitSettingsConstants::DefaultTimeoutKey)
+			{
+				DefaultCommandTimeout = Timeout;
+			}
+			else
+			{
+				CommandTimeouts.Add(SubCommand, Timeout);
+			}
+		}
+	}
 }
 
 void FGitSourceControlSettings::SaveSettings() const
@@ -138,5 +283,21 @@ void FGitSourceControlSettings::SaveSettings() const
 		GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("IsAdmin"), bIsAdmin, IniFile);
 		GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("UseLocking"), bUseLocking, IniFile);
 		GConfig->SetString(*GitSettingsConstants::SettingsSection, TEXT("LockingUsername"), *LockingUsername, IniFile);
+		GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("AutoConfigureRepository"), bAutoConfigureRepository, IniFile);
+		GConfig->SetInt(*GitSettingsConstants::SettingsSection, TEXT("MaxParallelGitProcesses"), MaxParallelGitProcesses, IniFile);
+
+		GConfig->SetFloat(*GitSettingsConstants::SettingsSection, TEXT("FullStatusScanInterval"), FullStatusScanInterval, IniFile);
+		GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("BackgroundForceUpdate"), bBackgroundForceUpdate, IniFile);
+		GConfig->SetFloat(*GitSettingsConstants::SettingsSection, TEXT("FetchInterval"), FetchInterval, IniFile);
+		GConfig->SetFloat(*GitSettingsConstants::SettingsSection, TEXT("FetchIntervalJitter"), FetchIntervalJitter, IniFile);
+		GConfig->SetFloat(*GitSettingsConstants::SettingsSection, TEXT("FetchStalenessBudget"), FetchStalenessBudget, IniFile);
+
+		TArray<FString> TimeoutEntries;
+		TimeoutEntries.Add(FString::Printf(TEXT("%s=%g"), *GitSettingsConstants::DefaultTimeoutKey, DefaultCommandTimeout));
+		for(const auto& Timeout : CommandTimeouts)
+		{
+			TimeoutEntries.Add(FString::Printf(TEXT("%s=%g"), *Timeout.Key, Timeout.Value));
+		}
+		GConfig->SetArray(*GitSettingsConstants::SettingsSection, TEXT("CommandTimeouts"), TimeoutEntries, IniFile);
 	}
 }
\ No newline at end of file
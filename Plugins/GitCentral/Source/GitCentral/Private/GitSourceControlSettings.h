@@ -35,6 +35,41 @@ public:
 	void SetIsAdmin(bool Admin);
 	bool IsAdmin() const;
 
+	/** Whether Connect applies the recommended performance settings to the repository, instead of only reporting them */
+	void SetAutoConfigureRepository(bool bInAutoConfigureRepository);
+	bool IsAutoConfiguringRepository() const;
+
+	/** Maximum number of git processes running at the same time for batches of read-only commands, 1 runs batches one after another */
+	void SetMaxParallelGitProcesses(int32 InMaxParallelGitProcesses);
+	int32 GetMaxParallelGitProcesses() const;
+
+	/** Seconds between two full status scans of the repository, refreshes in between only check the paths changed on disk. 0 always scans everything */
+	void SetFullStatusScanInterval(float InSeconds);
+	float GetFullStatusScanInterval() const;
+
+	/**
+	 * Whether GetState with ForceUpdate returns the cached states immediately and refreshes them in the background,
+	 * OnSourceControlStateChanged being broadcast when they change. Otherwise GetState waits for the status update
+	 */
+	void SetBackgroundForceUpdate(bool bInBackgroundForceUpdate);
+	bool IsBackgroundForceUpdate() const;
+
+	/** Seconds between two background fetches of the remote branch, plus up to FetchIntervalJitter seconds. 0 disables background fetches */
+	void SetFetchInterval(float InSeconds);
+	float GetFetchInterval() const;
+	void SetFetchIntervalJitter(float InSeconds);
+	float GetFetchIntervalJitter() const;
+
+	/** Age after which a status update fetches the remote branch itself instead of using the last fetch */
+	void SetFetchStalenessBudget(float InSeconds);
+	float GetFetchStalenessBudget() const;
+
+	/**
+	 * Time after which a git process is killed, per subcommand ("fetch", "lfs locks"...)
+	 * @returns the timeout in seconds, 0 if the process may run forever
+	 */
+	float GetCommandTimeout(const FString& InSubCommand) const;
+
 	/** Load settings from ini file */
 	void LoadSettings();
 
@@ -65,4 +100,35 @@ private:
 
 	/** Whether the user has administrator access to the remote repository */
 	bool bIsAdmin = false;
+
+	/** Whether Connect applies the recommended performance settings to the repository */
+	bool bAutoConfigureRepository = false;
+
+	/** Maximum number of git processes running at the same time for batches of read-only commands */
+	int32 MaxParallelGitProcesses = 4;
+
+	/** Seconds between two full status scans */
+	float FullStatusScanInterval = 600.f;
+
+	/**
+	 * Whether GetState with ForceUpdate refreshes the states in the background, returning the cached states.
+	 * Opt-in: the engine expects ForceUpdate to return up to date states.
+	 */
+	bool bBackgroundForceUpdate = false;
+
+	/** Seconds between two background fetches, and random delay added to each */
+	float FetchInterval = 300.f;
+	float FetchIntervalJitter = 30.f;
+
+	/** Age in seconds after which an asynchronous status update fetches, synchronous ones always fetch */
+	float FetchStalenessBudget = 600.f;
+
+	/** Timeout in seconds per subcommand, DefaultCommandTimeout applies to the others */
+	TMap<FString, float> CommandTimeouts;
+
+	/** Timeout in seconds of the subcommands without an explicit timeout, 0 for none: local and mutating commands are never killed by default */
+	float DefaultCommandTimeout = 0.f;
+
+	/** Set the default timeouts of the read-only subcommands likely to stall on the network or on a credential prompt */
+	void ResetCommandTimeouts();
 };
\ No newline at end of file
@@ -70,6 +70,14 @@ void FGitSourceControlState::CombineWithLocalState(const FGitSourceControlState&
 	if(Other.TimeStamp > TimeStamp)
 		TimeStamp = Other.TimeStamp;
 
+	//Object ids and submodule flags are only reported by git status
+	HeadObjectId = Other.HeadObjectId;
+	IndexObjectId = Other.IndexObjectId;
+	bIsSubmodule = Other.bIsSubmodule;
+	bSubmoduleCommitChanged = Other.bSubmoduleCommitChanged;
+	bSubmoduleHasTrackedChanges = Other.bSubmoduleHasTrackedChanges;
+	bSubmoduleHasUntrackedChanges = Other.bSubmoduleHasUntrackedChanges;
+
 	EWorkingCopyState::Type OtherWorkingCopyState = Other.WorkingCopyState;
 
 	switch(OtherWorkingCopyState)
@@ -317,7 +325,13 @@ bool FGitSourceControlState::operator==(const FGitSourceControlState& Other) con
 		&& CheckedOutRevision == Other.CheckedOutRevision
 		&& AbsoluteFilename == Other.AbsoluteFilename
 		&& UserLocked == Other.UserLocked
-		&& bLockedByOther == Other.bLockedByOther;
+		&& bLockedByOther == Other.bLockedByOther
+		&& HeadObjectId == Other.HeadObjectId
+		&& IndexObjectId == Other.IndexObjectId
+		&& bIsSubmodule == Other.bIsSubmodule
+		&& bSubmoduleCommitChanged == Other.bSubmoduleCommitChanged
+		&& bSubmoduleHasTrackedChanges == Other.bSubmoduleHasTrackedChanges
+		&& bSubmoduleHasUntrackedChanges == Other.bSubmoduleHasUntrackedChanges;
 }
 
 bool FGitSourceControlState::operator!=(const FGitSourceControlState& Other) const
@@ -695,6 +709,9 @@ void FGitSourceControlState::DebugPrint() const
 	if (bLockedByOther)
 		debugStr += FString::Printf(TEXT(" lockedByOther(%s)"), *UserLocked);
 
+	if (bIsSubmodule)
+		debugStr += FString::Printf(TEXT(" submodule(commit:%d tracked:%d untracked:%d)"), bSubmoduleCommitChanged, bSubmoduleHasTrackedChanges, bSubmoduleHasUntrackedChanges);
+
 	GITCENTRAL_LOG(TEXT("%s"), *debugStr);
 }
 
@@ -5,6 +5,7 @@
 #include "ISourceControlState.h"
 #include "GitSourceControlRevision.h"
 #include "Dom/JsonObject.h"
+#include "Misc/SecureHash.h"
 
 #include "GitSourceControlState.generated.h"
 
@@ -63,8 +64,8 @@ struct SavedState
 class FGitSourceControlState : public ISourceControlState, public TSharedFromThis<FGitSourceControlState, ESPMode::ThreadSafe>
 {
 public:
-	FGitSourceControlState( const FString& InLocalFilename )
-		: AbsoluteFilename(InLocalFilename)
+	FGitSourceControlState( FString InLocalFilename )
+		: AbsoluteFilename(MoveTemp(InLocalFilename))
 		, WorkingCopyState(EWorkingCopyState::Unknown)
 		, RemoteState(EWorkingCopyState::Unknown)
 		, TimeStamp(0)
@@ -72,6 +73,10 @@ public:
 		, bLockedByOther(false)
 		, bOutdated(false)
 		, bStaged(false)
+		, bIsSubmodule(false)
+		, bSubmoduleCommitChanged(false)
+		, bSubmoduleHasTrackedChanges(false)
+		, bSubmoduleHasUntrackedChanges(false)
 	{
 	}
 
@@ -84,6 +89,10 @@ public:
 		, bLockedByOther(false)
 		, bOutdated(false)
 		, bStaged(false)
+		, bIsSubmodule(false)
+		, bSubmoduleCommitChanged(false)
+		, bSubmoduleHasTrackedChanges(false)
+		, bSubmoduleHasUntrackedChanges(false)
 	{
 	}
 
@@ -213,4 +222,18 @@ public:
 
 	/** Whether this file is staged */
 	bool bStaged;
+
+	/** Object of the file in HEAD, as reported by git status. Zero if unknown or not in HEAD */
+	FSHAHash HeadObjectId;
+
+	/** Object of the file in the index, as reported by git status. Zero if unknown or not in the index */
+	FSHAHash IndexObjectId;
+
+	/** Whether this path is a submodule */
+	bool bIsSubmodule;
+
+	/** Submodule flags, only set if bIsSubmodule */
+	bool bSubmoduleCommitChanged;
+	bool bSubmoduleHasTrackedChanges;
+	bool bSubmoduleHasUntrackedChanges;
 };
@@ -0,0 +1,593 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlStateStore.h"
+#include "Misc/ScopeRWLock.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	/** Copy the component of a path starting at InStart, up to the next separator */
+	int32 GetPathComponent(const FString& InPath, int32 InStart, FString& OutComponent)
+	{
+		int32 End = InStart;
+		while(End < InPath.Len() && InPath[End] != '/')
+		{
+			End++;
+		}
+
+		OutComponent.Reset();
+		OutComponent.AppendChars(*InPath + InStart, End - InStart);
+		return End;
+	}
+}
+
+int32 FGitPathTable::FindOrAdd(const FString& InPath)
+{
+	//Note: every separator starts a new component, even a leading, trailing or repeated one, so the path can be rebuilt as is
+	int32 Node = INDEX_NONE;
+	FString Component;
+	int32 Start = 0;
+	while(true)
+	{
+		const int32 End = GetPathComponent(InPath, Start, Component);
+
+		//Note: TSet::Add would replace the casing of an existing component
+		FSetElementId NameId = Names.FindId(Component);
+		if(!NameId.IsValidId())
+		{
+			NameId = Names.Add(Component);
+		}
+
+		const uint64 Key = GetChildKey(Node, NameId.AsInteger());
+		if(const int32* Child = Children.Find(Key))
+		{
+			Node = *Child;
+		}
+		else
+		{
+			const int32 Parent = Node;
+			Node = Nodes.Add({ Parent, NameId.AsInteger() });
+			Children.Add(Key, Node);
+		}
+
+		if(End >= InPath.Len())
+		{
+			return Node;
+		}
+		Start = End + 1;
+	}
+}
+
+int32 FGitPathTable::Find(const FString& InPath) const
+{
+	int32 Node = INDEX_NONE;
+	FString Component;
+	int32 Start = 0;
+	while(true)
+	{
+		const int32 End = GetPathComponent(InPath, Start, Component);
+
+		const FSetElementId NameId = Names.FindId(Component);
+		if(!NameId.IsValidId())
+		{
+			return INDEX_NONE;
+		}
+
+		const int32* Child = Children.Find(GetChildKey(Node, NameId.AsInteger()));
+		if(Child == nullptr)
+		{
+			return INDEX_NONE;
+		}
+		Node = *Child;
+
+		if(End >= InPath.Len())
+		{
+			return Node;
+		}
+		Start = End + 1;
+	}
+}
+
+FString FGitPathTable::GetPath(int32 InId) const
+{
+	TArray<int32, TInlineAllocator<32>> Components;
+	int32 Length = 0;
+	for(int32 Node = InId; Node != INDEX_NONE; Node = Nodes[Node].Parent)
+	{
+		Components.Add(Nodes[Node].Name);
+		Length += Names[FSetElementId::FromInteger(Nodes[Node].Name)].Len() + 1;
+	}
+
+	FString Path;
+	Path.Reserve(Length);
+	for(int32 Index = Components.Num() - 1; Index >= 0; Index--)
+	{
+		Path += Names[FSetElementId::FromInteger(Components[Index])];
+		if(Index > 0)
+		{
+			Path += TEXT('/');
+		}
+	}
+	return Path;
+}
+
+void FGitPathTable::Empty()
+{
+	Nodes.Empty();
+	Names.Empty();
+	Children.Empty();
+}
+
+int32 FGitStateStrings::FindPath(const FString& InPath) const
+{
+	FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+	return Paths.Find(InPath);
+}
+
+int32 FGitStateStrings::FindOrAddPath(const FString& InPath)
+{
+	//Note: most paths are already interned, only take the write lock to add one
+	const int32 Existing = FindPath(InPath);
+	if(Existing != INDEX_NONE)
+	{
+		return Existing;
+	}
+
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	return Paths.FindOrAdd(InPath);
+}
+
+FString FGitStateStrings::GetPath(int32 InId) const
+{
+	FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+	return Paths.GetPath(InId);
+}
+
+int32 FGitStateStrings::Intern(const FString& InString)
+{
+	{
+		FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+		const FSetElementId Existing = Strings.FindId(InString);
+		if(Existing.IsValidId())
+		{
+			return Existing.AsInteger();
+		}
+	}
+
+	//Note: TSet::Add keeps the existing element if another writer added the same string meanwhile
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	return Strings.Add(InString).AsInteger();
+}
+
+FString FGitStateStrings::GetString(int32 InId) const
+{
+	FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+	return Strings[FSetElementId::FromInteger(InId)];
+}
+
+bool FGitStateStrings::StringEquals(int32 InId, const FString& InString) const
+{
+	FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+	return Strings[FSetElementId::FromInteger(InId)].Equals(InString, ESearchCase::CaseSensitive);
+}
+
+void FGitStateStrings::Empty()
+{
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	Paths.Empty();
+	Strings.Empty();
+}
+
+TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitStateShard::GetState(const FString& InFilename) const
+{
+	const int32 Slot = FindSlot(InFilename);
+	if(Slot != INDEX_NONE && (Flags[Slot] & Cached))
+	{
+		//Note: the same state is shared until it changes or nobody holds it anymore, the content browser queries the same files over and over
+		FScopeLock ScopeLock(&BuiltStatesCriticalSection);
+		if(const TWeakPtr<FGitSourceControlState, ESPMode::ThreadSafe>* Built = BuiltStates.Find(Slot))
+		{
+			if(TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> Pinned = Built->Pin())
+			{
+				return Pinned.ToSharedRef();
+			}
+		}
+		else if(BuiltStates.Num() >= BuiltStatesPruneThreshold)
+		{
+			PruneBuiltStates();
+		}
+
+		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = MakeState(Slot);
+		BuiltStates.Add(Slot, State);
+		return State;
+	}
+
+	//Note: unknown states are not cached, the path is only interned when a state is set
+	return MakeShared<FGitSourceControlState, ESPMode::ThreadSafe>(InFilename);
+}
+
+bool FGitStateShard::SetState(const FGitSourceControlState& InState)
+{
+	const int32 Slot = AddState(InState.AbsoluteFilename);
+	if(Equals(Slot, InState))
+	{
+		return false;
+	}
+
+	Flags[Slot] = Cached | GetFlags(InState);
+	WorkingCopyStates[Slot] = (uint8)InState.WorkingCopyState;
+	RemoteStates[Slot] = (uint8)InState.RemoteState;
+	CheckedOutRevisions[Slot] = Strings->Intern(InState.CheckedOutRevision);
+	UsersLocked[Slot] = Strings->Intern(InState.UserLocked);
+	LockIds[Slot] = InState.LockId;
+	TimeStamps[Slot] = FDateTime::Now();
+
+	if(InState.HeadObjectId != FSHAHash() || InState.IndexObjectId != FSHAHash())
+	{
+		ObjectIds.Add(Slot, { InState.HeadObjectId, InState.IndexObjectId });
+	}
+	else
+	{
+		ObjectIds.Remove(Slot);
+	}
+
+	InvalidateBuiltState(Slot);
+	return true;
+}
+
+void FGitStateShard::SetHistory(const FString& InFilename, const TGitSourceControlHistory& InHistory)
+{
+	const int32 Slot = AddState(InFilename);
+	Histories.Add(Slot, InHistory);
+	TimeStamps[Slot] = FDateTime::Now();
+	InvalidateBuiltState(Slot);
+}
+
+bool FGitStateShard::Remove(const FString& InFilename)
+{
+	const int32 Slot = FindSlot(InFilename);
+	if(Slot == INDEX_NONE || !(Flags[Slot] & Cached))
+	{
+		return false;
+	}
+
+	//Note: the slot and the path stay, they are only reclaimed by Empty()
+	Flags[Slot] = 0;
+	ObjectIds.Remove(Slot);
+	Histories.Remove(Slot);
+	InvalidateBuiltState(Slot);
+	NumStates--;
+	return true;
+}
+
+void FGitStateShard::Empty()
+{
+	Slots.Empty();
+	NumStates = 0;
+	PathIds.Empty();
+	Flags.Empty();
+	WorkingCopyStates.Empty();
+	RemoteStates.Empty();
+	CheckedOutRevisions.Empty();
+	UsersLocked.Empty();
+	LockIds.Empty();
+	TimeStamps.Empty();
+	ObjectIds.Empty();
+	Histories.Empty();
+	BuiltStates.Empty();
+	BuiltStatesPruneThreshold = GitStateStoreConstants::MinBuiltStatesPruneThreshold;
+}
+
+void FGitStateShard::PruneBuiltStates() const
+{
+	for(auto It = BuiltStates.CreateIterator(); It; ++It)
+	{
+		if(!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	BuiltStatesPruneThreshold = FMath::Max(GitStateStoreConstants::MinBuiltStatesPruneThreshold, BuiltStates.Num() * 2);
+}
+
+void FGitStateShard::ForEachState(TFunctionRef<void(const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>&)> InFunction) const
+{
+	FScopeLock ScopeLock(&BuiltStatesCriticalSection);
+	for(int32 Slot = 0; Slot < Flags.Num(); Slot++)
+	{
+		if(Flags[Slot] & Cached)
+		{
+			//Note: states are not kept for a walk of the whole cache, only the ones still held elsewhere are reused
+			const TWeakPtr<FGitSourceControlState, ESPMode::ThreadSafe>* Built = BuiltStates.Find(Slot);
+			const TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> Pinned = Built ? Built->Pin() : nullptr;
+			InFunction(Pinned.IsValid() ? Pinned.ToSharedRef() : MakeState(Slot));
+		}
+	}
+}
+
+void FGitStateShard::GetLockIds(TMap<FString, int32>& OutLockIds) const
+{
+	for(int32 Slot = 0; Slot < Flags.Num(); Slot++)
+	{
+		if((Flags[Slot] & Cached) && LockIds[Slot] != -1)
+		{
+			OutLockIds.Add(Strings->GetPath(PathIds[Slot]), LockIds[Slot]);
+		}
+	}
+}
+
+int32 FGitStateShard::FindSlot(const FString& InFilename) const
+{
+	const int32 PathId = Strings->FindPath(InFilename);
+	if(PathId == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	//Note: the path may only be known as the directory of a file of any shard
+	const int32* Slot = Slots.Find(PathId);
+	return Slot ? *Slot : INDEX_NONE;
+}
+
+int32 FGitStateShard::AddState(const FString& InFilename)
+{
+	const int32 PathId = Strings->FindOrAddPath(InFilename);
+	int32 Slot;
+	if(const int32* Existing = Slots.Find(PathId))
+	{
+		Slot = *Existing;
+	}
+	else
+	{
+		Slot = PathIds.Add(PathId);
+		Slots.Add(PathId, Slot);
+		Flags.AddZeroed();
+		WorkingCopyStates.AddZeroed();
+		RemoteStates.AddZeroed();
+		CheckedOutRevisions.AddZeroed();
+		UsersLocked.AddZeroed();
+		LockIds.AddZeroed();
+		TimeStamps.AddZeroed();
+	}
+
+	if(!(Flags[Slot] & Cached))
+	{
+		//Same values as a new FGitSourceControlState
+		Flags[Slot] = Cached;
+		WorkingCopyStates[Slot] = (uint8)EWorkingCopyState::Unknown;
+		RemoteStates[Slot] = (uint8)EWorkingCopyState::Unknown;
+		CheckedOutRevisions[Slot] = Strings->Intern(TEXT("0"));
+		UsersLocked[Slot] = Strings->Intern(FString());
+		LockIds[Slot] = -1;
+		TimeStamps[Slot] = FDateTime(0);
+		NumStates++;
+	}
+
+	return Slot;
+}
+
+TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitStateShard::MakeState(int32 InSlot) const
+{
+	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = MakeShared<FGitSourceControlState, ESPMode::ThreadSafe>(Strings->GetPath(PathIds[InSlot]));
+	const uint8 StateFlags = Flags[InSlot];
+	State->WorkingCopyState = (EWorkingCopyState::Type)WorkingCopyStates[InSlot];
+	State->RemoteState = (EWorkingCopyState::Type)RemoteStates[InSlot];
+	State->TimeStamp = TimeStamps[InSlot];
+	State->CheckedOutRevision = Strings->GetString(CheckedOutRevisions[InSlot]);
+	State->UserLocked = Strings->GetString(UsersLocked[InSlot]);
+	State->LockId = LockIds[InSlot];
+	State->bLockedByOther = (StateFlags & LockedByOther) != 0;
+	State->bOutdated = (StateFlags & Outdated) != 0;
+	State->bStaged = (StateFlags & Staged) != 0;
+	State->bIsSubmodule = (StateFlags & IsSubmodule) != 0;
+	State->bSubmoduleCommitChanged = (StateFlags & SubmoduleCommitChanged) != 0;
+	State->bSubmoduleHasTrackedChanges = (StateFlags & SubmoduleHasTrackedChanges) != 0;
+	State->bSubmoduleHasUntrackedChanges = (StateFlags & SubmoduleHasUntrackedChanges) != 0;
+
+	if(const FObjectIds* Objects = ObjectIds.Find(InSlot))
+	{
+		State->HeadObjectId = Objects->HeadObjectId;
+		State->IndexObjectId = Objects->IndexObjectId;
+	}
+
+	if(const TGitSourceControlHistory* History = Histories.Find(InSlot))
+	{
+		State->History = *History;
+	}
+
+	return State;
+}
+
+bool FGitStateShard::Equals(int32 InSlot, const FGitSourceControlState& InState) const
+{
+	//Note: same fields as FGitSourceControlState::operator==, the filename is the key
+	if(WorkingCopyStates[InSlot] != (uint8)InState.WorkingCopyState
+		|| RemoteStates[InSlot] != (uint8)InState.RemoteState
+		|| (Flags[InSlot] & ~Cached) != GetFlags(InState)
+		|| !Strings->StringEquals(CheckedOutRevisions[InSlot], InState.CheckedOutRevision)
+		|| !Strings->StringEquals(UsersLocked[InSlot], InState.UserLocked))
+	{
+		return false;
+	}
+
+	if(const FObjectIds* Objects = ObjectIds.Find(InSlot))
+	{
+		return Objects->HeadObjectId == InState.HeadObjectId && Objects->IndexObjectId == InState.IndexObjectId;
+	}
+	return InState.HeadObjectId == FSHAHash() && InState.IndexObjectId == FSHAHash();
+}
+
+uint8 FGitStateShard::GetFlags(const FGitSourceControlState& InState)
+{
+	return (InState.bLockedByOther ? LockedByOther : 0)
+		| (InState.bOutdated ? Outdated : 0)
+		| (InState.bStaged ? Staged : 0)
+		| (InState.bIsSubmodule ? IsSubmodule : 0)
+		| (InState.bSubmoduleCommitChanged ? SubmoduleCommitChanged : 0)
+		| (InState.bSubmoduleHasTrackedChanges ? SubmoduleHasTrackedChanges : 0)
+		| (InState.bSubmoduleHasUntrackedChanges ? SubmoduleHasUntrackedChanges : 0);
+}
+
+FGitStateStore::FGitStateStore()
+{
+	for(FShard& Shard : Shards)
+	{
+		Shard.States.SetStrings(&Strings);
+	}
+}
+
+TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitStateStore::GetState(const FString& InFilename) const
+{
+	const FShard& Shard = Shards[GetShardIndex(InFilename)];
+	FRWScopeLock Lock(Shard.Lock, SLT_ReadOnly);
+	return Shard.States.GetState(InFilename);
+}
+
+void FGitStateStore::GetStates(const TArray<FString>& InFilenames, TArray<TSharedRef<ISourceControlState, ESPMode::ThreadSafe>>& OutStates) const
+{
+	uint32 ShardMask = 0;
+	for(const FString& Filename : InFilenames)
+	{
+		ShardMask |= 1u << GetShardIndex(Filename);
+	}
+
+	OutStates.Reserve(OutStates.Num() + InFilenames.Num());
+	LockShards(ShardMask, false);
+	for(const FString& Filename : InFilenames)
+	{
+		OutStates.Add(Shards[GetShardIndex(Filename)].States.GetState(Filename));
+	}
+	UnlockShards(ShardMask, false);
+}
+
+void FGitStateStore::SetStates(const TArray<FGitSourceControlState>& InStates, TArray<FString>& OutChangedFiles)
+{
+	uint32 ShardMask = 0;
+	for(const FGitSourceControlState& State : InStates)
+	{
+		ShardMask |= 1u << GetShardIndex(State.AbsoluteFilename);
+	}
+
+	LockShards(ShardMask, true);
+	for(const FGitSourceControlState& State : InStates)
+	{
+		if(Shards[GetShardIndex(State.AbsoluteFilename)].States.SetState(State))
+		{
+			OutChangedFiles.Add(State.AbsoluteFilename);
+		}
+	}
+	UnlockShards(ShardMask, true);
+}
+
+void FGitStateStore::SetHistories(const TMap<FString, TGitSourceControlHistory>& InHistories)
+{
+	uint32 ShardMask = 0;
+	for(const auto& History : InHistories)
+	{
+		ShardMask |= 1u << GetShardIndex(History.Key);
+	}
+
+	LockShards(ShardMask, true);
+	for(const auto& History : InHistories)
+	{
+		Shards[GetShardIndex(History.Key)].States.SetHistory(History.Key, History.Value);
+	}
+	UnlockShards(ShardMask, true);
+}
+
+bool FGitStateStore::Remove(const FString& InFilename)
+{
+	FShard& Shard = Shards[GetShardIndex(InFilename)];
+	FRWScopeLock Lock(Shard.Lock, SLT_Write);
+	return Shard.States.Remove(InFilename);
+}
+
+void FGitStateStore::Empty()
+{
+	//Note: the shared path ids are only emptied once no shard refers to them anymore
+	const uint32 AllShards = (1u << GitStateStoreConstants::NumShards) - 1;
+	LockShards(AllShards, true);
+	for(FShard& Shard : Shards)
+	{
+		Shard.States.Empty();
+	}
+	Strings.Empty();
+	UnlockShards(AllShards, true);
+}
+
+int32 FGitStateStore::Num() const
+{
+	int32 Num = 0;
+	for(const FShard& Shard : Shards)
+	{
+		FRWScopeLock Lock(Shard.Lock, SLT_ReadOnly);
+		Num += Shard.States.Num();
+	}
+	return Num;
+}
+
+void FGitStateStore::ForEachState(TFunctionRef<void(const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>&)> InFunction) const
+{
+	//Note: the states are collected first, the function may query the store again
+	TArray<TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>> States;
+	const uint32 AllShards = (1u << GitStateStoreConstants::NumShards) - 1;
+	LockShards(AllShards, false);
+	for(const FShard& Shard : Shards)
+	{
+		Shard.States.ForEachState([&States](const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>& InState)
+		{
+			States.Add(InState);
+		});
+	}
+	UnlockShards(AllShards, false);
+
+	for(const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>& State : States)
+	{
+		InFunction(State);
+	}
+}
+
+void FGitStateStore::GetLockIds(TMap<FString, int32>& OutLockIds) const
+{
+	for(const FShard& Shard : Shards)
+	{
+		FRWScopeLock Lock(Shard.Lock, SLT_ReadOnly);
+		Shard.States.GetLockIds(OutLockIds);
+	}
+}
+
+void FGitStateStore::LockShards(uint32 InShardMask, bool bInWrite) const
+{
+	for(int32 Index = 0; Index < GitStateStoreConstants::NumShards; Index++)
+	{
+		if(InShardMask & (1u << Index))
+		{
+			if(bInWrite)
+			{
+				Shards[Index].Lock.WriteLock();
+			}
+			else
+			{
+				Shards[Index].Lock.ReadLock();
+			}
+		}
+	}
+}
+
+void FGitStateStore::UnlockShards(uint32 InShardMask, bool bInWrite) const
+{
+	for(int32 Index = GitStateStoreConstants::NumShards - 1; Index >= 0; Index--)
+	{
+		if(InShardMask & (1u << Index))
+		{
+			if(bInWrite)
+			{
+				Shards[Index].Lock.WriteUnlock();
+			}
+			else
+			{
+				Shards[Index].Lock.ReadUnlock();
+			}
+		}
+	}
+}
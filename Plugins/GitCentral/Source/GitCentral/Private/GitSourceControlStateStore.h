@@ -0,0 +1,276 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "GitSourceControlState.h"
+
+/**
+ * Interned paths, stored as a trie of path components: each directory and file name is stored once,
+ * a path is the id of its last component. Ids are stable until the table is emptied.
+ * Like the keys of a TMap<FString>, paths are case insensitive.
+ */
+class FGitPathTable
+{
+public:
+	/** @returns the id of a path, adding it if needed */
+	int32 FindOrAdd(const FString& InPath);
+
+	/** @returns the id of a path, INDEX_NONE if it was never added */
+	int32 Find(const FString& InPath) const;
+
+	/** @returns the path of an id */
+	FString GetPath(int32 InId) const;
+
+	/** Number of ids, paths and their parent directories */
+	int32 Num() const { return Nodes.Num(); }
+
+	void Empty();
+
+private:
+	struct FNode
+	{
+		int32 Parent;
+		int32 Name;
+	};
+
+	static uint64 GetChildKey(int32 InParent, int32 InName) { return (uint64(uint32(InParent)) << 32) | uint32(InName); }
+
+	TArray<FNode> Nodes;
+
+	/** Path components, a component id is its element id in the set */
+	TSet<FString> Names;
+
+	/** Node of each component, keyed by parent node and component name */
+	TMap<uint64, int32> Children;
+};
+
+/**
+ * Paths, revisions and lock owners interned once for all the shards of the FGitStateStore, with its own lock.
+ * Shards only store ids: the same directories and strings are not duplicated in every shard.
+ * Locked after the shard locks, and only for the duration of each call.
+ */
+class FGitStateStrings
+{
+public:
+	/** @returns the id of a path, INDEX_NONE if it was never added */
+	int32 FindPath(const FString& InPath) const;
+
+	/** @returns the id of a path, adding it if needed */
+	int32 FindOrAddPath(const FString& InPath);
+
+	/** @returns the path of an id */
+	FString GetPath(int32 InId) const;
+
+	/** @returns the id of a revision or user name, adding it if needed */
+	int32 Intern(const FString& InString);
+
+	/** @returns the string of an id */
+	FString GetString(int32 InId) const;
+
+	/** Whether the string of an id equals a string, case sensitively */
+	bool StringEquals(int32 InId, const FString& InString) const;
+
+	/** Forget all the paths and strings, ids become invalid */
+	void Empty();
+
+private:
+	/** Revisions and user names are compared case sensitively, unlike the default FString key functions */
+	struct FCaseSensitiveKeyFuncs : BaseKeyFuncs<FString, FString>
+	{
+		static const FString& GetSetKey(const FString& Element) { return Element; }
+		static bool Matches(const FString& A, const FString& B) { return A.Equals(B, ESearchCase::CaseSensitive); }
+		static uint32 GetKeyHash(const FString& Key) { return FCrc::StrCrc32(*Key); }
+	};
+
+	mutable FRWLock Lock;
+
+	FGitPathTable Paths;
+
+	/** Revisions and lock owners, a string id is its element id in the set */
+	TSet<FString, FCaseSensitiveKeyFuncs> Strings;
+};
+
+namespace GitStateStoreConstants
+{
+	/** Number of independently locked shards of the state cache, at most 32 */
+	static const int32 NumShards = 16;
+
+	/** Number of built states a shard keeps before pruning the ones nobody holds anymore */
+	static const int32 MinBuiltStatesPruneThreshold = 1024;
+}
+
+/**
+ * States of the files of one shard of the FGitStateStore, replacing one heap-allocated FGitSourceControlState per file.
+ * Paths, revisions and lock owners are interned in the FGitStateStrings shared by all the shards, the small fields are stored
+ * in arrays indexed by slot, one slot per file of the shard, and the rarely set fields (object ids, history) are kept aside.
+ *
+ * The ISourceControlState handles given to the engine are built from the store on first query, then shared by the following queries
+ * until the state changes or is no longer held: they are snapshots, never modified, the engine queries them again when OnSourceControlStateChanged is broadcast.
+ * Not thread safe, locked by the FGitStateStore: readers may run concurrently, writers run alone.
+ */
+class FGitStateShard
+{
+public:
+	/** Set the interned strings shared by the shards, before any other call */
+	void SetStrings(FGitStateStrings* InStrings) { Strings = InStrings; }
+
+	/** @returns the state of a file, a new unknown state if it is not cached */
+	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> GetState(const FString& InFilename) const;
+
+	/**
+	 * Cache the state of a file, keeping its history
+	 * @returns true if the state changed, its timestamp is updated then
+	 */
+	bool SetState(const FGitSourceControlState& InState);
+
+	/** Set the history of a file, adding an unknown state if needed */
+	void SetHistory(const FString& InFilename, const TGitSourceControlHistory& InHistory);
+
+	/** @returns true if the file was cached */
+	bool Remove(const FString& InFilename);
+
+	/** Forget all the states, the shared strings are emptied by the FGitStateStore */
+	void Empty();
+
+	/** Number of cached states */
+	int32 Num() const { return NumStates; }
+
+	/** Call a function with a new state for each cached file */
+	void ForEachState(TFunctionRef<void(const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>&)> InFunction) const;
+
+	/** Add the lock id of each cached file which has one */
+	void GetLockIds(TMap<FString, int32>& OutLockIds) const;
+
+private:
+	/** Bits of the Flags array */
+	enum EFlags : uint8
+	{
+		Cached = 1 << 0,
+		LockedByOther = 1 << 1,
+		Outdated = 1 << 2,
+		Staged = 1 << 3,
+		IsSubmodule = 1 << 4,
+		SubmoduleCommitChanged = 1 << 5,
+		SubmoduleHasTrackedChanges = 1 << 6,
+		SubmoduleHasUntrackedChanges = 1 << 7,
+	};
+
+	struct FObjectIds
+	{
+		FSHAHash HeadObjectId;
+		FSHAHash IndexObjectId;
+	};
+
+	/** @returns the slot of a file, INDEX_NONE if the shard never stored it */
+	int32 FindSlot(const FString& InFilename) const;
+
+	/** Make room for the state of a file, as cached unknown state. @returns its slot */
+	int32 AddState(const FString& InFilename);
+
+	/** Build a state from the arrays */
+	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> MakeState(int32 InSlot) const;
+
+	/** Forget the state built for a slot, it changed */
+	void InvalidateBuiltState(int32 InSlot) { BuiltStates.Remove(InSlot); }
+
+	/** Forget the built states nobody holds anymore, under BuiltStatesCriticalSection */
+	void PruneBuiltStates() const;
+
+	/** Whether the cached state equals another state, ignoring filename, history and timestamp */
+	bool Equals(int32 InSlot, const FGitSourceControlState& InState) const;
+
+	static uint8 GetFlags(const FGitSourceControlState& InState);
+
+	FGitStateStrings* Strings = nullptr;
+
+	/** Slot of each path id stored in this shard */
+	TMap<int32, int32> Slots;
+
+	int32 NumStates = 0;
+
+	/** States indexed by slot */
+	TArray<int32> PathIds;
+	TArray<uint8> Flags;
+	TArray<uint8> WorkingCopyStates;
+	TArray<uint8> RemoteStates;
+	TArray<int32> CheckedOutRevisions;
+	TArray<int32> UsersLocked;
+	TArray<int32> LockIds;
+	TArray<FDateTime> TimeStamps;
+
+	/** Object ids reported by git status, only for the states which have one */
+	TMap<int32, FObjectIds> ObjectIds;
+
+	/** Histories, only for the files which have one */
+	TMap<int32, TGitSourceControlHistory> Histories;
+
+	/** States already given out, by slot. Filled by concurrent readers under BuiltStatesCriticalSection, emptied by writers
+	 *  Weak so that the cache does not keep a second copy of every state ever queried, only the ones still held by the editor are shared */
+	mutable TMap<int32, TWeakPtr<FGitSourceControlState, ESPMode::ThreadSafe>> BuiltStates;
+	mutable FCriticalSection BuiltStatesCriticalSection;
+
+	/** Number of built states from which the expired ones are pruned before adding another one */
+	mutable int32 BuiltStatesPruneThreshold = GitStateStoreConstants::MinBuiltStatesPruneThreshold;
+};
+
+/**
+ * Cache of the states of the files, safe to read and update from worker threads.
+ * Files are spread over shards locked independently, readers only wait for a writer of the same shard.
+ * Paths and strings are interned once for all the shards, only the per-file states are sharded.
+ * Batches lock all the shards they touch at once, always in the same order: a batch of states is published atomically,
+ * and a batch read sees either none or all of the changes of a concurrent batch.
+ */
+class FGitStateStore
+{
+public:
+	FGitStateStore();
+
+	/** @returns the state of a file, a new unknown state if it is not cached */
+	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> GetState(const FString& InFilename) const;
+
+	/** Append the states of the files, in order */
+	void GetStates(const TArray<FString>& InFilenames, TArray<TSharedRef<ISourceControlState, ESPMode::ThreadSafe>>& OutStates) const;
+
+	/**
+	 * Cache the states of files, keeping their history
+	 * @param	OutChangedFiles		Appended with the files whose state changed
+	 */
+	void SetStates(const TArray<FGitSourceControlState>& InStates, TArray<FString>& OutChangedFiles);
+
+	/** Set the history of files, adding unknown states if needed */
+	void SetHistories(const TMap<FString, TGitSourceControlHistory>& InHistories);
+
+	/** @returns true if the file was cached */
+	bool Remove(const FString& InFilename);
+
+	/** Forget all the states */
+	void Empty();
+
+	/** Number of cached states */
+	int32 Num() const;
+
+	/** Call a function with a new state for each cached file. The function is called without holding any lock */
+	void ForEachState(TFunctionRef<void(const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>&)> InFunction) const;
+
+	/** Get the lock id of each cached file which has one, without building their states */
+	void GetLockIds(TMap<FString, int32>& OutLockIds) const;
+
+private:
+	struct FShard
+	{
+		mutable FRWLock Lock;
+		FGitStateShard States;
+	};
+
+	static uint32 GetShardIndex(const FString& InFilename) { return GetTypeHash(InFilename) % GitStateStoreConstants::NumShards; }
+
+	/** Lock the shards of a mask, in increasing order so that batches cannot deadlock */
+	void LockShards(uint32 InShardMask, bool bInWrite) const;
+	void UnlockShards(uint32 InShardMask, bool bInWrite) const;
+
+	FShard Shards[GitStateStoreConstants::NumShards];
+
+	FGitStateStrings Strings;
+};
@@ -0,0 +1,146 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlStats.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlCommand.h"
+#include "IGitSourceControlWorker.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformTime.h"
+
+namespace GitCommandStatsConstants
+{
+	/** Number of durations kept per entry to compute the percentiles */
+	static const int32 MaxRecentSamples = 256;
+}
+
+void FGitCommandStats::FEntry::Add(double InDurationSeconds, int64 InBytes, int32 InReturnCode, bool bInTimedOut)
+{
+	++Count;
+	if(InReturnCode != 0)
+	{
+		++Failures;
+	}
+	if(bInTimedOut)
+	{
+		++Timeouts;
+	}
+	TotalBytes += InBytes;
+	TotalSeconds += InDurationSeconds;
+	MaxSeconds = FMath::Max(MaxSeconds, InDurationSeconds);
+
+	if(RecentSeconds.Num() < GitCommandStatsConstants::MaxRecentSamples)
+	{
+		RecentSeconds.Add((float)InDurationSeconds);
+	}
+	else
+	{
+		RecentSeconds[NextRecent] = (float)InDurationSeconds;
+		NextRecent = (NextRecent + 1) % GitCommandStatsConstants::MaxRecentSamples;
+	}
+}
+
+FString FGitCommandStats::FEntry::ToString(const FString& InName) const
+{
+	TArray<float> Sorted = RecentSeconds;
+	Sorted.Sort();
+
+	// Nearest rank percentile over the recent samples
+	auto Percentile = [&Sorted](int32 InPercent) -> double
+	{
+		if(Sorted.Num() == 0)
+		{
+			return 0.0;
+		}
+		const int32 Rank = FMath::Clamp(FMath::CeilToInt(InPercent / 100.f * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+		return Sorted[Rank];
+	};
+
+	return FString::Printf(TEXT("%-32s count=%lld failed=%lld timeouts=%lld p50=%.1fms p95=%.1fms max=%.1fms total=%.2fs bytes=%lld"),
+		*InName, Count, Failures, Timeouts, Percentile(50) * 1000.0, Percentile(95) * 1000.0, MaxSeconds * 1000.0, TotalSeconds, TotalBytes);
+}
+
+void FGitCommandStats::Record(const FString& InSubCommand, FName InWorkerName, double InDurationSeconds, int64 InBytes, int32 InReturnCode, bool bInTimedOut)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	BySubCommand.FindOrAdd(InSubCommand).Add(InDurationSeconds, InBytes, InReturnCode, bInTimedOut);
+	ByWorker.FindOrAdd(InWorkerName).Add(InDurationSeconds, InBytes, InReturnCode, bInTimedOut);
+}
+
+void FGitCommandStats::Print() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	GITCENTRAL_LOG(TEXT("Git commands, by subcommand:"));
+	for(const auto& Entry : BySubCommand)
+	{
+		GITCENTRAL_LOG(TEXT("  %s"), *Entry.Value.ToString(Entry.Key));
+	}
+
+	GITCENTRAL_LOG(TEXT("Git commands, by worker:"));
+	for(const auto& Entry : ByWorker)
+	{
+		GITCENTRAL_LOG(TEXT("  %s"), *Entry.Value.ToString(Entry.Key.IsNone() ? TEXT("(no command)") : Entry.Key.ToString()));
+	}
+}
+
+void FGitCommandStats::Reset()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	BySubCommand.Reset();
+	ByWorker.Reset();
+}
+
+FString FGitCommandStats::GetSubCommand(const FString& InCommand)
+{
+	TArray<FString> Tokens;
+	InCommand.ParseIntoArrayWS(Tokens);
+	if(Tokens.Num() == 0)
+	{
+		return InCommand;
+	}
+
+	// "lfs locks", "lfs smudge"... are distinct commands
+	if(Tokens[0] == TEXT("lfs") && Tokens.Num() > 1)
+	{
+		return Tokens[0] + TEXT(" ") + Tokens[1];
+	}
+	return Tokens[0];
+}
+
+FGitScopedCommandTrace::FGitScopedCommandTrace(const FString& InCommand, int32 InFileCount)
+	: SubCommand(FGitCommandStats::GetSubCommand(InCommand))
+	, FileCount(InFileCount)
+	, StartTime(FPlatformTime::Seconds())
+	, Bytes(0)
+	, ReturnCode(-1)
+	, bTimedOut(false)
+{
+#if ENABLE_NAMED_EVENTS
+	//Note: dynamic named events show up in Unreal Insights, static cpu profiler scopes cannot carry the subcommand
+	FPlatformMisc::BeginNamedEvent(FColor::Orange, *FString::Printf(TEXT("git %s (%d files)"), *SubCommand, FileCount));
+#endif
+}
+
+FGitScopedCommandTrace::~FGitScopedCommandTrace()
+{
+#if ENABLE_NAMED_EVENTS
+	//Note: the name of the span is set when it begins, the results are reported by an event nested at its end
+	FPlatformMisc::BeginNamedEvent(ReturnCode == 0 ? FColor::Green : FColor::Red, *FString::Printf(TEXT("code=%d bytes=%lld%s"), ReturnCode, Bytes, bTimedOut ? TEXT(" (timed out)") : TEXT("")));
+	FPlatformMisc::EndNamedEvent();
+	FPlatformMisc::EndNamedEvent();
+#endif
+
+	const double Duration = FPlatformTime::Seconds() - StartTime;
+
+	FName WorkerName = NAME_None;
+	if(const FGitSourceControlCommand* Command = FGitSourceControlCommand::GetCurrent())
+	{
+		WorkerName = Command->Worker->GetName();
+	}
+
+	GITCENTRAL_VERBOSE(TEXT("Trace: git %s files=%d bytes=%lld code=%d%s worker=%s %.1fms"), *SubCommand, FileCount, Bytes, ReturnCode, bTimedOut ? TEXT(" (timed out)") : TEXT(""), *WorkerName.ToString(), Duration * 1000.0);
+
+	FGitSourceControlModule::GetInstance().GetProvider().GetCommandStats().Record(SubCommand, WorkerName, Duration, Bytes, ReturnCode, bTimedOut);
+}
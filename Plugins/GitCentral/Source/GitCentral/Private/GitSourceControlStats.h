@@ -0,0 +1,94 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Rolling aggregate of the git processes launched by the plugin, per subcommand and per worker.
+ * Used to attribute slow operations and editor hitches to specific git calls, see gitcentral.PrintStats.
+ * Thread safe, processes are recorded from worker threads.
+ */
+class FGitCommandStats
+{
+public:
+	/**
+	 * Record a finished git process
+	 * @param	InSubCommand		The git subcommand, e.g. "status" or "lfs locks"
+	 * @param	InWorkerName		The worker that launched it, or NAME_None outside of a command
+	 * @param	InDurationSeconds	Wall time from launch to exit
+	 * @param	InBytes				Size of the output read from the process
+	 * @param	InReturnCode		Exit code of the process
+	 * @param	bInTimedOut			Whether the process was killed because it exceeded its timeout
+	 */
+	void Record(const FString& InSubCommand, FName InWorkerName, double InDurationSeconds, int64 InBytes, int32 InReturnCode, bool bInTimedOut);
+
+	/** Print the aggregate to the log */
+	void Print() const;
+
+	/** Forget everything recorded so far */
+	void Reset();
+
+	/** @returns the subcommand used as stats key for a command line such as "diff --name-status -z" */
+	static FString GetSubCommand(const FString& InCommand);
+
+private:
+	struct FEntry
+	{
+		int64 Count = 0;
+		int64 Failures = 0;
+		int64 Timeouts = 0;
+		int64 TotalBytes = 0;
+		double TotalSeconds = 0.0;
+		double MaxSeconds = 0.0;
+
+		/** Durations of the last processes, as a ring buffer */
+		TArray<float> RecentSeconds;
+		int32 NextRecent = 0;
+
+		void Add(double InDurationSeconds, int64 InBytes, int32 InReturnCode, bool bInTimedOut);
+		FString ToString(const FString& InName) const;
+	};
+
+	mutable FCriticalSection CriticalSection;
+
+	TMap<FString, FEntry> BySubCommand;
+	TMap<FName, FEntry> ByWorker;
+};
+
+/**
+ * Scope of a git process: emits a named event for Unreal Insights and records the process in FGitCommandStats when it ends.
+ * The exit code and output size set with SetResult are reported by a nested event at the end of the span.
+ */
+class FGitScopedCommandTrace
+{
+public:
+	/**
+	 * @param	InCommand	The git command, e.g. "diff --name-status -z"
+	 * @param	InFileCount	Number of files passed to the command
+	 */
+	FGitScopedCommandTrace(const FString& InCommand, int32 InFileCount);
+	~FGitScopedCommandTrace();
+
+	/** Set the results of the process, to be recorded when the scope ends */
+	void SetResult(int64 InBytes, int32 InReturnCode)
+	{
+		Bytes = InBytes;
+		ReturnCode = InReturnCode;
+	}
+
+	/** Flag the process as killed by its timeout */
+	void SetTimedOut()
+	{
+		bTimedOut = true;
+	}
+
+private:
+	FString SubCommand;
+	int32 FileCount;
+	double StartTime;
+	int64 Bytes;
+	int32 ReturnCode;
+	bool bTimedOut;
+};
@@ -0,0 +1,118 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#include "GitSourceControlUpdateCoalescer.h"
+#include "GitSourceControlCommand.h"
+#include "GitSourceControlModule.h"
+#include "SourceControlOperations.h"
+#include "Misc/ScopeLock.h"
+
+bool FGitUpdateStatusCoalescer::Issue(FGitSourceControlCommand& InCommand)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	for(FGitSourceControlCommand* Waiting : WaitingCommands)
+	{
+		if(CanCoalesce(*Waiting, InCommand, true))
+		{
+			GITCENTRAL_VERBOSE(TEXT("UpdateStatus: merged %d files into a waiting update"), InCommand.Files.Num());
+			Merge(*Waiting, InCommand);
+			return false;
+		}
+	}
+
+	InCommand.IssueSequence = ++Sequence;
+	WaitingCommands.Add(&InCommand);
+	return true;
+}
+
+bool FGitUpdateStatusCoalescer::Start(FGitSourceControlCommand& InCommand)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	WaitingCommands.RemoveSingle(&InCommand);
+
+	//Note: a command started before this one was issued may have read the status before the change this one was requested for
+	for(FGitSourceControlCommand* Running : RunningCommands)
+	{
+		if(Running->StartSequence > InCommand.IssueSequence && CanCoalesce(*Running, InCommand, false))
+		{
+			GITCENTRAL_VERBOSE(TEXT("UpdateStatus: %d files already covered by a running update"), InCommand.Files.Num());
+			Merge(*Running, InCommand);
+			InCommand.bCoalesced = true;
+			return false;
+		}
+	}
+
+	InCommand.StartSequence = ++Sequence;
+	RunningCommands.Add(&InCommand);
+	return true;
+}
+
+void FGitUpdateStatusCoalescer::Finish(FGitSourceControlCommand& InCommand)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	WaitingCommands.RemoveSingle(&InCommand);
+	RunningCommands.RemoveSingle(&InCommand);
+}
+
+bool FGitUpdateStatusCoalescer::CanCoalesce(const FGitSourceControlCommand& InTarget, const FGitSourceControlCommand& InCommand, bool bInCanAddFiles)
+{
+	if(InTarget.PathToRepositoryRoot != InCommand.PathToRepositoryRoot || InTarget.Branch != InCommand.Branch || InTarget.Remote != InCommand.Remote)
+	{
+		return false;
+	}
+
+	const FUpdateStatus& TargetOperation = static_cast<const FUpdateStatus&>(InTarget.Operation.Get());
+	const FUpdateStatus& Operation = static_cast<const FUpdateStatus&>(InCommand.Operation.Get());
+	if(TargetOperation.ShouldUpdateHistory() != Operation.ShouldUpdateHistory()
+		|| TargetOperation.ShouldGetOpenedOnly() != Operation.ShouldGetOpenedOnly()
+		|| TargetOperation.ShouldUpdateModifiedState() != Operation.ShouldUpdateModifiedState())
+	{
+		return false;
+	}
+
+	//Without files, the operation flags tell what is updated: a check of all files covers any file
+	if(InTarget.Files.Num() == 0)
+	{
+		return TargetOperation.ShouldCheckAllFiles() || (InCommand.Files.Num() == 0 && !Operation.ShouldCheckAllFiles());
+	}
+	if(InCommand.Files.Num() == 0)
+	{
+		return false;
+	}
+
+	if(bInCanAddFiles)
+	{
+		return true;
+	}
+
+	const TSet<FString> TargetFiles(InTarget.Files);
+	for(const FString& File : InCommand.Files)
+	{
+		if(!TargetFiles.Contains(File))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FGitUpdateStatusCoalescer::Merge(FGitSourceControlCommand& InTarget, FGitSourceControlCommand& InCommand)
+{
+	if(InTarget.Files.Num() > 0)
+	{
+		TSet<FString> TargetFiles(InTarget.Files);
+		for(const FString& File : InCommand.Files)
+		{
+			bool bAlreadyInSet = false;
+			TargetFiles.Add(File, &bAlreadyInSet);
+			if(!bAlreadyInSet)
+			{
+				InTarget.Files.Add(File);
+			}
+		}
+	}
+
+	InTarget.MergedRequests.Emplace(InCommand.Operation, InCommand.OperationCompleteDelegate);
+	InTarget.MergedRequests.Append(MoveTemp(InCommand.MergedRequests));
+	InCommand.MergedRequests.Reset();
+}
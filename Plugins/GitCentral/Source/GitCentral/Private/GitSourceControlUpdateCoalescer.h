@@ -0,0 +1,53 @@
+// Copyright (c) 2017-2020 Samuel Kahn (samuel@kahncode.com). All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+class FGitSourceControlCommand;
+
+/**
+ * Merges the asynchronous UpdateStatus commands requested for the same repository, so that one fetch and status pipeline
+ * serves all of them. A command issued while a compatible one waits for a worker thread is merged into it: files are united
+ * and the completion delegates of both are called when it completes. A command about to start whose files are covered
+ * by a running command, started after it was issued, does not run and completes with that command.
+ * Thread safe.
+ */
+class FGitUpdateStatusCoalescer
+{
+public:
+	/**
+	 * Register a command before it is queued
+	 * @returns false if the command was merged into a waiting command, it must be deleted instead of queued
+	 */
+	bool Issue(FGitSourceControlCommand& InCommand);
+
+	/**
+	 * Called by a command when a worker thread picks it up
+	 * @returns false if a running command covers it, it must complete without running
+	 */
+	bool Start(FGitSourceControlCommand& InCommand);
+
+	/** Called by a command when it stopped running or was abandoned, nothing can be merged into it anymore */
+	void Finish(FGitSourceControlCommand& InCommand);
+
+private:
+	/**
+	 * Whether a command can serve the requests of another one
+	 * @param	bInCanAddFiles	Whether the files of the command can be added to the target, otherwise the target must already include them
+	 */
+	static bool CanCoalesce(const FGitSourceControlCommand& InTarget, const FGitSourceControlCommand& InCommand, bool bInCanAddFiles);
+
+	/** Move the files and the requests of a command to another one */
+	static void Merge(FGitSourceControlCommand& InTarget, FGitSourceControlCommand& InCommand);
+
+	FCriticalSection CriticalSection;
+
+	/** Commands queued but not started yet, and commands running */
+	TArray<FGitSourceControlCommand*> WaitingCommands;
+	TArray<FGitSourceControlCommand*> RunningCommands;
+
+	/** Increases every time a command is issued or started */
+	uint64 Sequence = 0;
+};
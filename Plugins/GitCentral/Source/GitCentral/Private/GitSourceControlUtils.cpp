@@ -4,7 +4,14 @@
 #include "GitSourceControlState.h"
 #include "GitSourceControlModule.h"
 #include "GitSourceControlCommand.h"
+#include "GitSourceControlCatFile.h"
+#include "GitSourceControlProcess.h"
+#include "GitSourceControlStats.h"
+#include "GitSourceControlCommitGraph.h"
 #include "Misc/EngineVersionComparison.h"
+#include "Async/Async.h"
+#include "Misc/Parse.h"
+#include "Misc/ScopeLock.h"
 
 #if PLATFORM_LINUX
 #include <sys/ioctl.h>
@@ -39,8 +46,11 @@ static FORCEINLINE bool CreatePipeWrite(void*& ReadPipe, void*& WritePipe)
 
 namespace GitSourceControlConstants
 {
-	/** The maximum number of files we submit in a single Git command */
+	/** The maximum number of files we submit in a single Git command, for commands or git versions that cannot read them from stdin */
 	const int32 MaxFilesPerBatch = 50;
+
+	/** Seconds during which the status of files answered by the index reuses the locks of the last query instead of asking the LFS server */
+	const double MaxLockCacheAge = 60.0;
 }
 
 FScopedTempFile::FScopedTempFile(const FText& InText)
@@ -72,12 +82,10 @@ const FString& FScopedTempFile::GetFilename() const
 namespace GitSourceControlUtils
 {
 
-// Launch the Git command line process and extract its results & errors
-static bool RunCommandInternalRaw(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors)
+// Build the full command line and a short version of it for logging purpose
+static FString BuildCommandLine(const FString& InCommand, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutLogableCommand)
 {
-	int32 ReturnCode = 0;
 	FString FullCommand;
-	FString LogableCommand; // short version of the command for logging purpose
 
 	if(!InRepositoryRoot.IsEmpty())
 	{
@@ -104,30 +112,235 @@ static bool RunCommandInternalRaw(const FString& InCommand, const FString& InPat
 		FullCommand += FPaths::Combine(*RepositoryRoot, TEXT(".git\" "));*/
 	}
 	// then the git command itself ("status", "log", "commit"...)
-	LogableCommand += InCommand;
+	OutLogableCommand = InCommand;
 
 	// Append to the command all parameters, and then finally the files
 	for(const auto& Parameter : InParameters)
 	{
-		LogableCommand += TEXT(" ");
-		LogableCommand += Parameter;
+		OutLogableCommand += TEXT(" ");
+		OutLogableCommand += Parameter;
 	}
 	for(const auto& File : InFiles)
 	{
-		LogableCommand += TEXT(" \"");
-		LogableCommand += File;
-		LogableCommand += TEXT("\"");
+		OutLogableCommand += TEXT(" \"");
+		OutLogableCommand += File;
+		OutLogableCommand += TEXT("\"");
 	}
 	// Also, Git does not have a "--non-interactive" option, as it auto-detects when there are no connected standard input/output streams
 
-	FullCommand += LogableCommand;
+	FullCommand += OutLogableCommand;
+	return FullCommand;
+}
+
+static FString BytesToString(const TArray<uint8>& InBytes)
+{
+	FUTF8ToTCHAR Converted((const ANSICHAR*)InBytes.GetData(), InBytes.Num());
+	return FString(Converted.Length(), Converted.Get());
+}
+
+// Whether the command may move refs, in which case resolved refs and merge-bases are no longer valid
+static bool IsRefMutatingCommand(const FString& InCommand)
+{
+	FString SubCommand = InCommand;
+	InCommand.Split(TEXT(" "), &SubCommand, nullptr);
+
+	static const TCHAR* RefMutatingCommands[] = { TEXT("fetch"), TEXT("pull"), TEXT("push"), TEXT("reset"), TEXT("commit"), TEXT("rebase"), TEXT("merge"), TEXT("checkout"), TEXT("stash"), TEXT("tag"), TEXT("branch"), TEXT("cherry-pick"), TEXT("revert"), TEXT("update-ref") };
+	for(const TCHAR* RefMutatingCommand : RefMutatingCommands)
+	{
+		if(SubCommand == RefMutatingCommand)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// True if the command executed by this thread was cancelled, its git processes must be terminated
+static bool IsCurrentCommandCancelled()
+{
+	const FGitSourceControlCommand* Command = FGitSourceControlCommand::GetCurrent();
+	return Command != nullptr && Command->IsCancelled();
+}
+
+// Time after which the process of a git command is killed, 0 if it may run forever
+static double GetCommandTimeout(const FString& InCommand)
+{
+	//Note: rollbacks run within a FGitScopedIgnoreCancel, killing them would leave the repository worse than waiting for them
+	const FGitSourceControlCommand* Command = FGitSourceControlCommand::GetCurrent();
+	if(Command != nullptr && Command->IgnoreCancelCount > 0)
+	{
+		return 0.0;
+	}
+	return FGitSourceControlModule::GetInstance().AccessSettings().GetCommandTimeout(FGitCommandStats::GetSubCommand(InCommand));
+}
+
+// Error reported when a process is killed by its timeout, always starts with "Timeout:" so it can be told apart from git errors
+static FString MakeTimeoutError(const FString& InCommand, double InTimeout)
+{
+	return FString::Printf(TEXT("Timeout: git %s did not complete within %.0f seconds and was terminated (CommandTimeouts in the GitCentral.Settings section)"), *FGitCommandStats::GetSubCommand(InCommand), InTimeout);
+}
+
+// The resolution cache of the command running on this thread, if it operates on this repository
+static FGitRefResolutionCache* GetRefResolutionCache(const FString& InRepositoryRoot)
+{
+	FGitSourceControlCommand* Command = FGitSourceControlCommand::GetCurrent();
+	return (Command && Command->PathToRepositoryRoot == InRepositoryRoot) ? &Command->RefCache : nullptr;
+}
+
+// Run a stage of a command on the thread pool, on behalf of the command so that it shares its caches and is cancelled with it
+//Note: the commands waiting for their stages run on the threads of the scheduler, never on the global thread pool, so a stage cannot wait behind its own command
+static TFuture<bool> RunCommandStage(FGitSourceControlCommand& InCommand, TUniqueFunction<bool()> InStage)
+{
+	return Async(EAsyncExecution::ThreadPool, [&InCommand, Stage = MoveTemp(InStage)]()
+	{
+		FGitScopedCurrentCommand CurrentCommand(InCommand);
+		return Stage();
+	});
+}
+
+// Wait for a stage started with RunCommandStage, a stage that was not started succeeds
+static bool WaitForCommandStage(TFuture<bool>& InStage)
+{
+	return InStage.IsValid() ? InStage.Get() : true;
+}
+
+/**
+ * Launch the Git command line process and hand its output over as it is produced
+ * @param	InOnOutput				Called whenever new output is available with all the output not consumed yet, consumed bytes must be removed from the buffer.
+ *									Called one last time with bInFinal once the process has exited.
+ * @param	bInPathspecFromStdIn	Pass the files as NUL separated pathspecs on stdin instead of the command line, the command must support --pathspec-from-file
+ */
+static bool RunCommandInternalProcess(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TFunctionRef<void(TArray<uint8>& InOutBuffer, bool bInFinal)> InOnOutput, FString& OutErrors, bool bInPathspecFromStdIn = false)
+{
+	FString LogableCommand;
+	FString FullCommand;
+	if(bInPathspecFromStdIn)
+	{
+		//Note: options must come before the parameters, which may end with "--"
+		TArray<FString> Parameters;
+		Parameters.Reserve(InParameters.Num() + 2);
+		Parameters.Add(TEXT("--pathspec-from-file=-"));
+		Parameters.Add(TEXT("--pathspec-file-nul"));
+		Parameters.Append(InParameters);
+		FullCommand = BuildCommandLine(InCommand, InRepositoryRoot, Parameters, TArray<FString>(), LogableCommand);
+		LogableCommand += FString::Printf(TEXT(" (%d files on stdin)"), InFiles.Num());
+	}
+	else
+	{
+		FullCommand = BuildCommandLine(InCommand, InRepositoryRoot, InParameters, InFiles, LogableCommand);
+	}
 
 	GITCENTRAL_VERBOSE(TEXT("ExecProcess: 'git %s'"), *LogableCommand);
-	
-	FPlatformProcess::ExecProcess(*InPathToGitBinary, *FullCommand, &ReturnCode, &OutResults, &OutErrors);
 
-	GITCENTRAL_VERBOSE(TEXT("ExecProcess: ReturnCode=%d OutResults='%s'"), ReturnCode, *OutResults);
-	if (ReturnCode != 0)
+	if(IsCurrentCommandCancelled())
+	{
+		OutErrors = FString::Printf(TEXT("Cancelled git %s"), *InCommand);
+		return false;
+	}
+
+	FGitScopedCommandTrace Trace(InCommand, InFiles.Num());
+	int64 TotalBytesRead = 0;
+
+	const double Timeout = GetCommandTimeout(InCommand);
+	const double StartTime = FPlatformTime::Seconds();
+
+	FGitProcess Process;
+	if(!Process.Launch(InPathToGitBinary, FullCommand, bInPathspecFromStdIn))
+	{
+		OutErrors = FString::Printf(TEXT("Failed to launch git %s"), *InCommand);
+		return false;
+	}
+
+	if(bInPathspecFromStdIn)
+	{
+		//Note: git reads the whole pathspec list before doing any work, so this cannot deadlock on a full stdout pipe
+		TArray<uint8> Pathspecs;
+		for(const FString& File : InFiles)
+		{
+			FTCHARToUTF8 Converted(*File, File.Len());
+			Pathspecs.Append((const uint8*)Converted.Get(), Converted.Length());
+			Pathspecs.Add(0);
+		}
+		if(!Process.WriteStdIn(Pathspecs.GetData(), Pathspecs.Num()))
+		{
+			GITCENTRAL_ERROR(TEXT("Failed to write pathspecs to git %s"), *InCommand);
+		}
+		Process.CloseStdIn();
+	}
+
+	TArray<uint8> OutputBuffer;
+	TArray<uint8> ErrorBuffer;
+	int32 IdleIterations = 0;
+	bool bCancelled = false;
+	bool bTimedOut = false;
+	for(;;)
+	{
+		if(!bCancelled && !bTimedOut)
+		{
+			// Both kill the whole process tree: credential helpers, lfs transfer agents...
+			if(IsCurrentCommandCancelled())
+			{
+				GITCENTRAL_LOG(TEXT("Cancelled git %s"), *InCommand);
+				Process.Terminate();
+				bCancelled = true;
+			}
+			else if(Timeout > 0.0 && FPlatformTime::Seconds() - StartTime > Timeout)
+			{
+				GITCENTRAL_ERROR(TEXT("git %s timed out after %.0fs, terminating it"), *InCommand, Timeout);
+				Process.Terminate();
+				bTimedOut = true;
+				Trace.SetTimedOut();
+			}
+		}
+
+		//Note: test before reading so that nothing written right before exiting is missed
+		const bool bWasRunning = Process.IsRunning();
+		const int32 BytesRead = Process.ReadStdOut(OutputBuffer);
+		const int32 ErrorBytesRead = Process.ReadStdErr(ErrorBuffer);
+		TotalBytesRead += BytesRead;
+
+		if(BytesRead > 0)
+		{
+			InOnOutput(OutputBuffer, false);
+		}
+
+		if(!bWasRunning)
+		{
+			break;
+		}
+
+		if(BytesRead + ErrorBytesRead == 0)
+		{
+			FGitProcess::WaitBackOff(IdleIterations);
+		}
+		else
+		{
+			IdleIterations = 0;
+		}
+	}
+	InOnOutput(OutputBuffer, true);
+
+	const int32 ReturnCode = Process.GetReturnCode();
+	OutErrors = BytesToString(ErrorBuffer);
+	if(bCancelled)
+	{
+		OutErrors += FString::Printf(TEXT("\nCancelled git %s"), *InCommand);
+	}
+	else if(bTimedOut)
+	{
+		OutErrors += TEXT("\n") + MakeTimeoutError(InCommand, Timeout);
+	}
+	Process.Close();
+	Trace.SetResult(TotalBytesRead, ReturnCode);
+
+	// Even a failed command may have moved some refs
+	if(IsRefMutatingCommand(InCommand) && FGitSourceControlCommand::GetCurrent())
+	{
+		FGitSourceControlCommand::GetCurrent()->RefCache.Invalidate();
+	}
+
+	GITCENTRAL_VERBOSE(TEXT("ExecProcess: ReturnCode=%d"), ReturnCode);
+	if(ReturnCode != 0)
 	{
 		GITCENTRAL_VERBOSE(TEXT("ExecProcess: ReturnCode=%d OutErrors='%s'"), ReturnCode, *OutErrors);
 	}
@@ -135,14 +348,66 @@ static bool RunCommandInternalRaw(const FString& InCommand, const FString& InPat
 	return ReturnCode == 0;
 }
 
+// Launch the Git command line process and extract its results & errors
+static bool RunCommandInternalRaw(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors, bool bInPathspecFromStdIn = false)
+{
+	const bool bResult = RunCommandInternalProcess(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles,
+		[&OutResults](TArray<uint8>& InOutBuffer, bool bInFinal)
+		{
+			if(bInFinal)
+			{
+				OutResults = BytesToString(InOutBuffer);
+			}
+		}, OutErrors, bInPathspecFromStdIn);
+
+	GITCENTRAL_VERBOSE(TEXT("ExecProcess: OutResults='%s'"), *OutResults);
+
+	return bResult;
+}
+
+// Pass each complete record of the output to a callback and remove them from the buffer
+static void SplitRecords(TArray<uint8>& InOutBuffer, bool bInFinal, ANSICHAR InDelimiter, TFunctionRef<void(const ANSICHAR* InData, int32 InSize)> InOnRecord)
+{
+	const ANSICHAR* Data = (const ANSICHAR*)InOutBuffer.GetData();
+	int32 RecordStart = 0;
+	for(int32 Index = 0; Index < InOutBuffer.Num(); ++Index)
+	{
+		if(Data[Index] == InDelimiter)
+		{
+			InOnRecord(Data + RecordStart, Index - RecordStart);
+			RecordStart = Index + 1;
+		}
+	}
+
+	// Unterminated last record
+	if(bInFinal && RecordStart < InOutBuffer.Num())
+	{
+		InOnRecord(Data + RecordStart, InOutBuffer.Num() - RecordStart);
+		RecordStart = InOutBuffer.Num();
+	}
+
+	// Only keep the incomplete record so memory stays bound by the size of a record, not the size of the output
+	InOutBuffer.RemoveAt(0, RecordStart, false);
+}
+
+// Launch the Git command line process and pass each record of its output to a callback, the data is only valid during the call
+static bool RunCommandInternalRecords(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, ANSICHAR InDelimiter, TFunctionRef<void(const ANSICHAR* InData, int32 InSize)> InOnRecord, FString& OutErrors)
+{
+	return RunCommandInternalProcess(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles,
+		[InDelimiter, &InOnRecord](TArray<uint8>& InOutBuffer, bool bInFinal)
+		{
+			SplitRecords(InOutBuffer, bInFinal, InDelimiter, InOnRecord);
+		}, OutErrors);
+}
+
 // Basic parsing or results & errors from the Git command line process
-static bool RunCommandInternal(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+static bool RunCommandInternal(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages, bool bInPathspecFromStdIn = false)
 {
 	bool bResult;
 	FString Results;
 	FString Errors;
 
-	bResult = RunCommandInternalRaw(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, Results, Errors);
+	bResult = RunCommandInternalRaw(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, Results, Errors, bInPathspecFromStdIn);
 
 	TArray<FString> AppendResults;
 	Results.ParseIntoArray(AppendResults, TEXT("\n"), true);
@@ -155,6 +420,171 @@ static bool RunCommandInternal(const FString& InCommand, const FString& InPathTo
 	return bResult;
 }
 
+/**
+ * Launch the batches of a read-only command concurrently, polling all the processes from the calling thread.
+ * The output of each batch is handed over to InOnOutput in batch order, the same way RunCommandInternalProcess does for a single process:
+ * the oldest running batch streams its output, the following ones buffer it until their turn so results are merged deterministically.
+ */
+static bool RunCommandInternalParallel(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<TArray<FString>>& InBatches, int32 InMaxProcesses, TFunctionRef<void(TArray<uint8>& InOutBuffer, bool bInFinal)> InOnOutput, TArray<FString>& OutErrorMessages)
+{
+	struct FBatch
+	{
+		FGitProcess Process;
+		TArray<uint8> Output;
+		TArray<uint8> Errors;
+		double StartTime = 0.0;
+		bool bLaunched = false;
+		bool bFinished = false;
+		bool bTimedOut = false;
+	};
+
+	TArray<TUniquePtr<FBatch>> Batches;
+	Batches.SetNum(InBatches.Num());
+
+	// The batches are traced as a single invocation: named events must nest on the polling thread
+	int32 TotalFiles = 0;
+	for(const TArray<FString>& Files : InBatches)
+	{
+		TotalFiles += Files.Num();
+	}
+	FGitScopedCommandTrace Trace(InCommand, TotalFiles);
+	int64 TotalBytesRead = 0;
+
+	// Each batch gets the full timeout, they are independent processes
+	const double Timeout = GetCommandTimeout(InCommand);
+	int32 FirstFailedReturnCode = 0;
+
+	bool bResult = true;
+	bool bCancelled = false;
+	int32 NextToLaunch = 0;
+	int32 NextToDeliver = 0;
+	int32 RunningProcesses = 0;
+	int32 IdleIterations = 0;
+	while(NextToDeliver < InBatches.Num())
+	{
+		if(!bCancelled && IsCurrentCommandCancelled())
+		{
+			GITCENTRAL_LOG(TEXT("Cancelled git %s"), *InCommand);
+			bCancelled = true;
+		}
+
+		// Once cancelled, the remaining batches are not launched and fail right away
+		while(NextToLaunch < InBatches.Num() && (RunningProcesses < InMaxProcesses || bCancelled))
+		{
+			TUniquePtr<FBatch>& Batch = Batches[NextToLaunch];
+			Batch = MakeUnique<FBatch>();
+
+			FString LogableCommand;
+			const FString FullCommand = BuildCommandLine(InCommand, InRepositoryRoot, InParameters, InBatches[NextToLaunch], LogableCommand);
+			GITCENTRAL_VERBOSE(TEXT("ExecProcess: 'git %s' (batch %d/%d)"), *LogableCommand, NextToLaunch + 1, InBatches.Num());
+
+			Batch->StartTime = FPlatformTime::Seconds();
+			Batch->bLaunched = !bCancelled && Batch->Process.Launch(InPathToGitBinary, FullCommand);
+			Batch->bFinished = !Batch->bLaunched;
+			if(Batch->bLaunched)
+			{
+				++RunningProcesses;
+			}
+			++NextToLaunch;
+		}
+
+		bool bAnyRead = false;
+		for(int32 Index = NextToDeliver; Index < NextToLaunch; ++Index)
+		{
+			FBatch& Batch = *Batches[Index];
+			if(Batch.bFinished)
+			{
+				continue;
+			}
+
+			if(bCancelled)
+			{
+				Batch.Process.Terminate();
+			}
+			else if(Timeout > 0.0 && !Batch.bTimedOut && FPlatformTime::Seconds() - Batch.StartTime > Timeout)
+			{
+				GITCENTRAL_ERROR(TEXT("git %s (batch %d/%d) timed out after %.0fs, terminating it"), *InCommand, Index + 1, InBatches.Num(), Timeout);
+				Batch.Process.Terminate();
+				Batch.bTimedOut = true;
+				Trace.SetTimedOut();
+			}
+
+			//Note: test before reading so that nothing written right before exiting is missed
+			const bool bWasRunning = Batch.Process.IsRunning();
+			const int32 BytesRead = Batch.Process.ReadStdOut(Batch.Output);
+			const int32 ErrorBytesRead = Batch.Process.ReadStdErr(Batch.Errors);
+			bAnyRead |= (BytesRead + ErrorBytesRead) > 0;
+			TotalBytesRead += BytesRead;
+
+			if(Index == NextToDeliver && BytesRead > 0)
+			{
+				InOnOutput(Batch.Output, false);
+			}
+
+			if(!bWasRunning)
+			{
+				Batch.bFinished = true;
+				--RunningProcesses;
+			}
+		}
+
+		// Deliver finished batches in order
+		while(NextToDeliver < NextToLaunch && Batches[NextToDeliver]->bFinished)
+		{
+			FBatch& Batch = *Batches[NextToDeliver];
+			InOnOutput(Batch.Output, true);
+
+			FString Errors;
+			if(Batch.bLaunched)
+			{
+				const int32 ReturnCode = Batch.Process.GetReturnCode();
+				bResult &= ReturnCode == 0;
+				if(FirstFailedReturnCode == 0)
+				{
+					FirstFailedReturnCode = ReturnCode;
+				}
+				Errors = BytesToString(Batch.Errors);
+				if(Batch.bTimedOut)
+				{
+					Errors += TEXT("\n") + MakeTimeoutError(InCommand, Timeout);
+				}
+				GITCENTRAL_VERBOSE(TEXT("ExecProcess: batch %d/%d ReturnCode=%d"), NextToDeliver + 1, InBatches.Num(), ReturnCode);
+			}
+			else
+			{
+				bResult = false;
+				FirstFailedReturnCode = -1;
+				Errors = FString::Printf(bCancelled ? TEXT("Cancelled git %s") : TEXT("Failed to launch git %s"), *InCommand);
+			}
+
+			TArray<FString> AppendErrors;
+			Errors.ParseIntoArray(AppendErrors, TEXT("\n"), true);
+			OutErrorMessages.Append(AppendErrors);
+
+			Batches[NextToDeliver].Reset();
+			++NextToDeliver;
+
+			// The next batch may already have buffered output
+			if(NextToDeliver < NextToLaunch && Batches[NextToDeliver]->Output.Num() > 0)
+			{
+				InOnOutput(Batches[NextToDeliver]->Output, false);
+			}
+		}
+
+		if(bAnyRead)
+		{
+			IdleIterations = 0;
+		}
+		else
+		{
+			FGitProcess::WaitBackOff(IdleIterations);
+		}
+	}
+
+	Trace.SetResult(TotalBytesRead, FirstFailedReturnCode);
+	return bResult;
+}
+
 static FString GetAppDataLocalPath()
 {
 #if UE_VERSION_NEWER_THAN(4, 21, 0)
@@ -279,6 +709,49 @@ namespace GitCapabilities
 	static bool bGitAvailable = false;
 	static bool bGitLfsAvailable = false;
 	static bool bSupportsLocking = false;
+
+	/** Version of the git binary, from "git version 2.28.0.windows.1" */
+	static int32 GitVersionMajor = 0;
+	static int32 GitVersionMinor = 0;
+
+	/** status --porcelain=v2 requires git 2.11 */
+	static bool bSupportsStatusV2 = false;
+
+	/** --pathspec-from-file requires git 2.25 for add, checkout, commit, reset, restore and rm, and git 2.26 for stash push */
+	static bool bSupportsPathspecFromFile = false;
+	static bool bSupportsStashPathspecFromFile = false;
+
+	static bool IsGitVersionAtLeast(int32 InMajor, int32 InMinor)
+	{
+		return GitVersionMajor > InMajor || (GitVersionMajor == InMajor && GitVersionMinor >= InMinor);
+	}
+}
+
+// Parse the output of "git version"
+static void ParseGitVersion(const FString& InVersionString)
+{
+	GitCapabilities::GitVersionMajor = 0;
+	GitCapabilities::GitVersionMinor = 0;
+
+	const TCHAR* VersionPrefix = TEXT("git version ");
+	if(InVersionString.StartsWith(VersionPrefix))
+	{
+		TArray<FString> Numbers;
+		InVersionString.Mid(FCString::Strlen(VersionPrefix)).ParseIntoArray(Numbers, TEXT("."), true);
+		if(Numbers.Num() >= 2)
+		{
+			GitCapabilities::GitVersionMajor = FCString::Atoi(*Numbers[0]);
+			GitCapabilities::GitVersionMinor = FCString::Atoi(*Numbers[1]);
+		}
+	}
+
+	GitCapabilities::bSupportsStatusV2 = GitCapabilities::IsGitVersionAtLeast(2, 11);
+	GitCapabilities::bSupportsPathspecFromFile = GitCapabilities::IsGitVersionAtLeast(2, 25);
+	GitCapabilities::bSupportsStashPathspecFromFile = GitCapabilities::IsGitVersionAtLeast(2, 26);
+	if(!GitCapabilities::bSupportsStatusV2)
+	{
+		GITCENTRAL_ERROR(TEXT("git outdated version %d.%d, update to 2.11 or later to handle paths with special characters and ensure proper function"), GitCapabilities::GitVersionMajor, GitCapabilities::GitVersionMinor);
+	}
 }
 
 bool CheckGitAvailability(const FString& InPathToGitBinary)
@@ -289,6 +762,8 @@ bool CheckGitAvailability(const FString& InPathToGitBinary)
 
 	if(GitCapabilities::bGitAvailable && InfoMessages.Contains("git"))
 	{
+		ParseGitVersion(InfoMessages.TrimStartAndEnd());
+
 		InfoMessages.Empty();
 		GitCapabilities::bGitLfsAvailable = RunCommandInternalRaw(TEXT("lfs version"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
 		if(GitCapabilities::bGitLfsAvailable &&InfoMessages.StartsWith("git-lfs/"))
@@ -446,27 +921,108 @@ void GetRemoteNames(const FString& InPathToGitBinary, const FString& InRepositor
 	}
 }
 
+// Whether the files of this command can be passed on stdin, which avoids batching
+static bool SupportsPathspecFromFile(const FString& InCommand)
+{
+	FString SubCommand = InCommand;
+	FString Options;
+	InCommand.Split(TEXT(" "), &SubCommand, &Options);
+
+	if(SubCommand == TEXT("stash"))
+	{
+		return GitCapabilities::bSupportsStashPathspecFromFile && Options.StartsWith(TEXT("push"));
+	}
+
+	static const TCHAR* SupportedCommands[] = { TEXT("add"), TEXT("checkout"), TEXT("commit"), TEXT("reset"), TEXT("restore"), TEXT("rm") };
+	for(const TCHAR* SupportedCommand : SupportedCommands)
+	{
+		if(SubCommand == SupportedCommand)
+		{
+			return GitCapabilities::bSupportsPathspecFromFile;
+		}
+	}
+	return false;
+}
+
+// Whether the command only reads the repository, so that its batches can run concurrently
+static bool IsReadOnlyCommand(const FString& InCommand)
+{
+	FString SubCommand = InCommand;
+	InCommand.Split(TEXT(" "), &SubCommand, nullptr);
+
+	static const TCHAR* ReadOnlyCommands[] = { TEXT("status"), TEXT("diff"), TEXT("log"), TEXT("show"), TEXT("ls-files"), TEXT("ls-tree"), TEXT("check-attr"), TEXT("cat-file"), TEXT("rev-parse"), TEXT("rev-list"), TEXT("merge-base"), TEXT("blame") };
+	for(const TCHAR* ReadOnlyCommand : ReadOnlyCommands)
+	{
+		if(SubCommand == ReadOnlyCommand)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// How many batches of this command can run at the same time
+static int32 GetMaxParallelProcesses(const FString& InCommand)
+{
+	if(!IsReadOnlyCommand(InCommand))
+	{
+		return 1;
+	}
+
+	const int32 MaxParallelGitProcesses = FGitSourceControlModule::GetInstance().AccessSettings().GetMaxParallelGitProcesses();
+	return FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1, FMath::Max(1, MaxParallelGitProcesses));
+}
+
+// Split files up so we dont exceed command-line limits
+static void SplitIntoBatches(const TArray<FString>& InFiles, TArray<TArray<FString>>& OutBatches)
+{
+	OutBatches.Reserve(OutBatches.Num() + FMath::DivideAndRoundUp(InFiles.Num(), GitSourceControlConstants::MaxFilesPerBatch));
+	for(int32 FileCount = 0; FileCount < InFiles.Num(); FileCount += GitSourceControlConstants::MaxFilesPerBatch)
+	{
+		const int32 BatchSize = FMath::Min(GitSourceControlConstants::MaxFilesPerBatch, InFiles.Num() - FileCount);
+		OutBatches.Emplace(InFiles.GetData() + FileCount, BatchSize);
+	}
+}
+
 bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
 {
 	bool bResult = true;
 
-	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
+	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch && SupportsPathspecFromFile(InCommand))
+	{
+		// All files in a single process, without command-line limits
+		bResult &= RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages, true);
+	}
+	else if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
 	{
 		// Batch files up so we dont exceed command-line limits
-		int32 FileCount = 0;
-		while(FileCount < InFiles.Num())
+		TArray<TArray<FString>> Batches;
+		SplitIntoBatches(InFiles, Batches);
+
+		const int32 MaxProcesses = GetMaxParallelProcesses(InCommand);
+		if(MaxProcesses > 1)
 		{
-			TArray<FString> FilesInBatch;
-			for(int32 FileIndex = 0; FileCount < InFiles.Num() && FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
+			bResult &= RunCommandInternalParallel(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, Batches, MaxProcesses,
+				[&OutResults](TArray<uint8>& InOutBuffer, bool bInFinal)
+				{
+					if(bInFinal)
+					{
+						TArray<FString> BatchResults;
+						BytesToString(InOutBuffer).ParseIntoArray(BatchResults, TEXT("\n"), true);
+						OutResults += BatchResults;
+					}
+				}, OutErrorMessages);
+		}
+		else
+		{
+			for(const TArray<FString>& FilesInBatch : Batches)
 			{
-				FilesInBatch.Add(InFiles[FileCount]);
+				TArray<FString> BatchResults;
+				TArray<FString> BatchErrors;
+				bResult &= RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, FilesInBatch, BatchResults, BatchErrors);
+				OutResults += BatchResults;
+				OutErrorMessages += BatchErrors;
 			}
-
-			TArray<FString> BatchResults;
-			TArray<FString> BatchErrors;
-			bResult &= RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, FilesInBatch, BatchResults, BatchErrors);
-			OutResults += BatchResults;
-			OutErrorMessages += BatchErrors;
 		}
 	}
 	else
@@ -477,13 +1033,86 @@ bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, cons
 	return bResult;
 }
 
+// Run a Git command by batches, passing each record of output to the callback as soon as it is read
+static bool RunCommandRecords(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, ANSICHAR InDelimiter, TFunctionRef<void(const ANSICHAR* InData, int32 InSize)> InOnRecord, TArray<FString>& OutErrorMessages)
+{
+	auto RunBatch = [&](const TArray<FString>& InBatchFiles)
+	{
+		FString Errors;
+		const bool bBatchResult = RunCommandInternalRecords(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InBatchFiles, InDelimiter, InOnRecord, Errors);
+
+		TArray<FString> AppendErrors;
+		Errors.ParseIntoArray(AppendErrors, TEXT("\n"), true);
+		OutErrorMessages.Append(AppendErrors);
+		return bBatchResult;
+	};
+
+	bool bResult = true;
+
+	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
+	{
+		// Batch files up so we dont exceed command-line limits
+		TArray<TArray<FString>> Batches;
+		SplitIntoBatches(InFiles, Batches);
+
+		const int32 MaxProcesses = GetMaxParallelProcesses(InCommand);
+		if(MaxProcesses > 1)
+		{
+			bResult &= RunCommandInternalParallel(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, Batches, MaxProcesses,
+				[InDelimiter, &InOnRecord](TArray<uint8>& InOutBuffer, bool bInFinal)
+				{
+					SplitRecords(InOutBuffer, bInFinal, InDelimiter, InOnRecord);
+				}, OutErrorMessages);
+		}
+		else
+		{
+			for(const TArray<FString>& FilesInBatch : Batches)
+			{
+				bResult &= RunBatch(FilesInBatch);
+			}
+		}
+	}
+	else
+	{
+		bResult &= RunBatch(InFiles);
+	}
+
+	return bResult;
+}
+
+// Run a Git command by batches, passing each line of output to the callback as soon as it is read
+bool RunCommandStreamed(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TFunctionRef<void(FStringView)> InOnLine, TArray<FString>& OutErrorMessages)
+{
+	return RunCommandRecords(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, '\n',
+		[&InOnLine](const ANSICHAR* InData, int32 InSize)
+		{
+			// Windows line endings
+			if(InSize > 0 && InData[InSize - 1] == '\r')
+			{
+				--InSize;
+			}
+			if(InSize == 0)
+			{
+				return;
+			}
+
+			FUTF8ToTCHAR Converted(InData, InSize);
+			InOnLine(FStringView(Converted.Get(), Converted.Length()));
+		}, OutErrorMessages);
+}
+
 // Run a Git "commit" command by batches
 bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
 {
 	//Note : this is not currently called as commit is implemented differently
 	bool bResult = true;
 
-	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
+	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch && SupportsPathspecFromFile(TEXT("commit")))
+	{
+		// A single commit with all files, no need to amend it
+		bResult &= RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages, true);
+	}
+	else if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
 	{
 		// Batch files up so we dont exceed command-line limits
 		int32 FileCount = 0;
@@ -527,10 +1156,86 @@ bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot
 	return bResult;
 }
 
+// Build the absolute path of a file from its path relative to the repository root, see FPaths::Combine
+static FString MakeAbsolutePath(const FString& InRepositoryRoot, FStringView InRelativePath)
+{
+	FString AbsolutePath;
+	AbsolutePath.Reserve(InRepositoryRoot.Len() + InRelativePath.Len() + 1);
+	AbsolutePath += InRepositoryRoot;
+	if(AbsolutePath.Len() > 0 && AbsolutePath[AbsolutePath.Len() - 1] != TEXT('/') && InRelativePath.Len() > 0 && InRelativePath[0] != TEXT('/'))
+	{
+		AbsolutePath += TEXT('/');
+	}
+	AbsolutePath.AppendChars(InRelativePath.GetData(), InRelativePath.Len());
+	return AbsolutePath;
+}
+
+// Find the first occurrence of a substring in a view
+static int32 FindInView(FStringView InView, const TCHAR* InSubString)
+{
+	const int32 SubStringLen = FCString::Strlen(InSubString);
+	for(int32 Index = 0; Index + SubStringLen <= InView.Len(); ++Index)
+	{
+		if(FCString::Strncmp(InView.GetData() + Index, InSubString, SubStringLen) == 0)
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+// Find the first occurrence of a character in a view, starting from an offset
+static int32 FindCharInView(FStringView InView, TCHAR InChar, int32 InStartIndex = 0)
+{
+	for(int32 Index = InStartIndex; Index < InView.Len(); ++Index)
+	{
+		if(InView[Index] == InChar)
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+// Find the last occurrence of a character in a view
+static int32 FindLastCharInView(FStringView InView, TCHAR InChar)
+{
+	for(int32 Index = InView.Len() - 1; Index >= 0; --Index)
+	{
+		if(InView[Index] == InChar)
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+static FStringView SubView(FStringView InView, int32 InStart, int32 InCount = MAX_int32)
+{
+	InStart = FMath::Clamp(InStart, 0, InView.Len());
+	InCount = FMath::Clamp(InCount, 0, InView.Len() - InStart);
+	return FStringView(InView.GetData() + InStart, InCount);
+}
+
+static FStringView TrimView(FStringView InView)
+{
+	int32 Start = 0;
+	int32 End = InView.Len();
+	while(Start < End && FChar::IsWhitespace(InView[Start]))
+	{
+		++Start;
+	}
+	while(End > Start && FChar::IsWhitespace(InView[End - 1]))
+	{
+		--End;
+	}
+	return SubView(InView, Start, End - Start);
+}
+
 /**
- * Extract and interpret the file state from the given Git status result.
+ * Interpret the XY code of a Git status result, shared by porcelain v1 and v2.
  * @see http://git-scm.com/docs/git-status
- * ' ' = unchanged
+ * ' ' = unchanged ('.' in porcelain v2)
  * 'M' = modified
  * 'A' = added
  * 'D' = deleted
@@ -539,43 +1244,17 @@ bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot
  * 'U' = updated but unmerged
  * '?' = unknown/untracked
  * '!' = ignored
-
-*Example output with edge cases
-*Note that files in directories that aren't known by source control aren't shown in git status --porcelain
-
-*λ git status --porcelain
-*A  "dir/file with spaces.txt"
-*R  dir/file.txt -> dir/file_2.txt
-*/
-
-static void ParseStatusLine(const FString& InLine, const FString& InRepositoryRoot, TMap<FString, FGitSourceControlState>& OutStates)
+ * @returns true if the file was renamed, the caller must then add the state of the new path
+ */
+static bool ApplyStatusCode(TCHAR IndexState, TCHAR WCopyState, FGitSourceControlState& OutState)
 {
-	if(InLine.Len() < 2)
-		return;
-
-	// Extract the relative filename from the Git status result
-	//TODO : if the filename has spaces, quotes need to be escaped
-	FString RelativeFilename = InLine.RightChop(3);
-	FString RelativeFilenameRenamed;
-
-	// Note: this is not enough in case of a rename from -> to
-	int32 RenameIndex = RelativeFilename.Find(" -> ");
-	if(RenameIndex != INDEX_NONE)
-	{
-		RelativeFilenameRenamed = RelativeFilename.Mid(RenameIndex + 4);
-		RelativeFilename = RelativeFilename.Left(RenameIndex);
-	}
-
-	if(RelativeFilename.IsEmpty())
-		return;
-
-	//Restore absolute path in the state
-	FGitSourceControlState State(FPaths::Combine(InRepositoryRoot, RelativeFilename));
-
-	TCHAR IndexState = InLine[0];
-	TCHAR WCopyState = InLine[1];
+	if(IndexState == '.')
+		IndexState = ' ';
+	if(WCopyState == '.')
+		WCopyState = ' ';
 
-	State.bStaged = IndexState != ' ';
+	bool bRenamed = false;
+	OutState.bStaged = IndexState != ' ';
 
 	if((IndexState == 'U' || WCopyState == 'U')
 		|| (IndexState == 'A' && WCopyState == 'A')
@@ -583,153 +1262,430 @@ static void ParseStatusLine(const FString& InLine, const FString& InRepositoryRo
 	{
 		// "Unmerged" conflict cases are generally marked with a "U",
 		// but there are also the special cases of both "A"dded, or both "D"eleted
-		State.WorkingCopyState = EWorkingCopyState::Conflicted;
+		OutState.WorkingCopyState = EWorkingCopyState::Conflicted;
 	}
 	else if(IndexState == 'A')
 	{
-		State.WorkingCopyState = EWorkingCopyState::Added;
+		OutState.WorkingCopyState = EWorkingCopyState::Added;
 	}
 	else if(IndexState == 'D' || WCopyState == 'D')
 	{
-		State.WorkingCopyState = EWorkingCopyState::Deleted;
+		OutState.WorkingCopyState = EWorkingCopyState::Deleted;
 	}
 	else if(IndexState == 'M' || WCopyState == 'M')
 	{
-		State.WorkingCopyState = EWorkingCopyState::Modified;
+		OutState.WorkingCopyState = EWorkingCopyState::Modified;
 	}
 	else if(IndexState == '?' || WCopyState == '?')
 	{
-		State.WorkingCopyState = EWorkingCopyState::NotControlled;
-		State.bStaged = false;
+		OutState.WorkingCopyState = EWorkingCopyState::NotControlled;
+		OutState.bStaged = false;
 	}
 	else if(IndexState == '!' || WCopyState == '!')
 	{
-		State.WorkingCopyState = EWorkingCopyState::Ignored;
+		OutState.WorkingCopyState = EWorkingCopyState::Ignored;
 	}
 	else if(IndexState == 'R')
 	{
-		State.WorkingCopyState = EWorkingCopyState::Deleted;
-
-		FGitSourceControlState RenamedState(FPaths::Combine(InRepositoryRoot, RelativeFilenameRenamed));
-		RenamedState.WorkingCopyState = EWorkingCopyState::NotControlled;
-		RenamedState.UpdateTimeStamp();
-		if(!OutStates.Find(RenamedState.GetFilename()))
-			OutStates.Add(RenamedState.GetFilename(), MoveTemp(RenamedState));
+		OutState.WorkingCopyState = EWorkingCopyState::Deleted;
+		bRenamed = true;
 	}
 	else if(IndexState == 'C')
 	{
 		//TODO: Test this, it is unhandled across the board so far
-		State.WorkingCopyState = EWorkingCopyState::Unknown;
+		OutState.WorkingCopyState = EWorkingCopyState::Unknown;
 	}
 	else
 	{
 		// unchanged never yield a status
-		State.WorkingCopyState = EWorkingCopyState::Unknown;
+		OutState.WorkingCopyState = EWorkingCopyState::Unknown;
 	}
 
-	State.UpdateTimeStamp();
-	OutStates.Add(State.GetFilename(), MoveTemp(State));
-};
+	return bRenamed;
+}
+
+/**
+ * Extract and interpret the file state from the given Git status --porcelain (v1) result.
+ * Only used with git versions that do not support porcelain v2.
+
+*Example output with edge cases
+*Note that files in directories that aren't known by source control aren't shown in git status --porcelain
 
-/** Interpret the line from a --name-status command and return a FGitSourceControlState */
-static void ParseNameStatusLine(const FString& InLine, const FString& InRepositoryRoot, TMap<FString, FGitSourceControlState>& OutStates)
+*λ git status --porcelain
+*A  "dir/file with spaces.txt"
+*R  dir/file.txt -> dir/file_2.txt
+*/
+static void ParseStatusLine(FStringView InLine, const FString& InRepositoryRoot, TMap<FString, FGitSourceControlState>& OutStates)
 {
 	if(InLine.Len() < 2)
 		return;
 
 	// Extract the relative filename from the Git status result
 	//TODO : if the filename has spaces, quotes need to be escaped
-	FString RelativeFilename;
-	FString RelativeFilenameRenamed;
-	int32 TabIndex = INDEX_NONE;
-	if(InLine.FindChar('\t', TabIndex))
+	FStringView RelativeFilename = SubView(InLine, 3);
+	FStringView RelativeFilenameRenamed;
+
+	// Note: this is not enough in case of a rename from -> to
+	const int32 RenameIndex = FindInView(RelativeFilename, TEXT(" -> "));
+	if(RenameIndex != INDEX_NONE)
+	{
+		RelativeFilenameRenamed = SubView(RelativeFilename, RenameIndex + 4);
+		RelativeFilename = SubView(RelativeFilename, 0, RenameIndex);
+	}
+
+	if(RelativeFilename.Len() == 0)
+		return;
+
+	//Restore absolute path in the state
+	FGitSourceControlState State(MakeAbsolutePath(InRepositoryRoot, RelativeFilename));
+
+	if(ApplyStatusCode(InLine[0], InLine[1], State))
 	{
-		RelativeFilename = InLine.Mid(TabIndex + 1);
+		FGitSourceControlState RenamedState(MakeAbsolutePath(InRepositoryRoot, RelativeFilenameRenamed));
+		RenamedState.WorkingCopyState = EWorkingCopyState::NotControlled;
+		RenamedState.UpdateTimeStamp();
+		if(!OutStates.Find(RenamedState.GetFilename()))
+			OutStates.Add(RenamedState.GetFilename(), MoveTemp(RenamedState));
+	}
+
+	State.UpdateTimeStamp();
+	OutStates.Add(State.GetFilename(), MoveTemp(State));
+};
+
+// Build the absolute path of a file from its UTF-8 path relative to the repository root, as output by git
+static FString MakeAbsolutePath(const FString& InRepositoryRoot, FAnsiStringView InRelativePathUtf8)
+{
+	FUTF8ToTCHAR Converted(InRelativePathUtf8.GetData(), InRelativePathUtf8.Len());
+	return MakeAbsolutePath(InRepositoryRoot, FStringView(Converted.Get(), Converted.Length()));
+}
 
-		int32 LastTabIndex = INDEX_NONE;
-		if(RelativeFilename.FindLastChar('\t', LastTabIndex))
+// Split the next space separated field of a porcelain v2 record, fields are always followed by at least the path
+static bool NextStatusField(FAnsiStringView& InOutRecord, FAnsiStringView& OutField)
+{
+	for(int32 Index = 0; Index < InOutRecord.Len(); ++Index)
+	{
+		if(InOutRecord[Index] == ' ')
 		{
-			RelativeFilenameRenamed = RelativeFilename.Mid(LastTabIndex + 1);
-			RelativeFilename = RelativeFilename.Left(LastTabIndex);
+			OutField = FAnsiStringView(InOutRecord.GetData(), Index);
+			InOutRecord = FAnsiStringView(InOutRecord.GetData() + Index + 1, InOutRecord.Len() - Index - 1);
+			return true;
 		}
 	}
-	else
+	return false;
+}
+
+static bool SkipStatusFields(FAnsiStringView& InOutRecord, int32 InCount)
+{
+	FAnsiStringView Field;
+	for(int32 Index = 0; Index < InCount; ++Index)
 	{
+		if(!NextStatusField(InOutRecord, Field))
+			return false;
+	}
+	return true;
+}
+
+// Read a hexadecimal object name, anything that is not a SHA-1 is left as zero
+static void ParseObjectId(FAnsiStringView InHex, FSHAHash& OutHash)
+{
+	OutHash = FSHAHash();
+	const int32 HashSize = (int32)UE_ARRAY_COUNT(OutHash.Hash);
+	if(InHex.Len() != 2 * HashSize)
 		return;
+
+	for(int32 Index = 0; Index < HashSize; ++Index)
+	{
+		OutHash.Hash[Index] = (uint8)((FParse::HexDigit(InHex[2 * Index]) << 4) | FParse::HexDigit(InHex[2 * Index + 1]));
 	}
-	
-	//Restore absolute path in the state
-	FGitSourceControlState State(FPaths::Combine(InRepositoryRoot, RelativeFilename));
+}
+
+// Submodule field of porcelain v2: "N..." for regular files, "S<c><m><u>" for submodules
+static void ParseSubmoduleField(FAnsiStringView InField, FGitSourceControlState& OutState)
+{
+	OutState.bIsSubmodule = InField.Len() == 4 && InField[0] == 'S';
+	OutState.bSubmoduleCommitChanged = OutState.bIsSubmodule && InField[1] == 'C';
+	OutState.bSubmoduleHasTrackedChanges = OutState.bIsSubmodule && InField[2] == 'M';
+	OutState.bSubmoduleHasUntrackedChanges = OutState.bIsSubmodule && InField[3] == 'U';
+}
 
-	switch(InLine[0])
+/**
+ * Parser of the NUL separated records of 'git status --porcelain=v2 -z', fed one record at a time.
+ * Works directly on the UTF-8 output, the only string created per entry is its absolute filename.
+ * Paths are never quoted with -z, which fixes files with spaces or special characters.
+ * @see https://git-scm.com/docs/git-status#_porcelain_format_version_2
+ *
+ * 1 <XY> <sub> <mH> <mI> <mW> <hH> <hI> <path>
+ * 2 <XY> <sub> <mH> <mI> <mW> <hH> <hI> <X><score> <path>\0<origPath>
+ * u <XY> <sub> <m1> <m2> <m3> <mW> <h1> <h2> <h3> <path>
+ * ? <path>
+ * ! <path>
+ */
+class FStatusV2Parser
+{
+public:
+	FStatusV2Parser(const FString& InRepositoryRoot, TMap<FString, FGitSourceControlState>& InOutStates)
+		: RepositoryRoot(InRepositoryRoot)
+		, States(InOutStates)
+		, bExpectOriginalPath(false)
+		, PendingIndexState(' ')
+		, PendingWCopyState(' ')
 	{
-	case TEXT(' '):
-		State.WorkingCopyState = EWorkingCopyState::Unchanged;
-		break;
-	case TEXT('T'):
-	case TEXT('M'):
-		State.WorkingCopyState = EWorkingCopyState::Modified;
-		break;
-	case TEXT('A'):
-		State.WorkingCopyState = EWorkingCopyState::Added;
-		break;
-	case TEXT('D'):
-		State.WorkingCopyState = EWorkingCopyState::Deleted;
-		break;
-	case TEXT('R'):
+	}
+
+	void ParseRecord(const ANSICHAR* InData, int32 InSize)
 	{
-		State.WorkingCopyState = EWorkingCopyState::Deleted;
+		FAnsiStringView Record(InData, InSize);
 
-		FGitSourceControlState RenamedState(FPaths::Combine(InRepositoryRoot, RelativeFilenameRenamed));
-		RenamedState.WorkingCopyState = EWorkingCopyState::Added;
-		RenamedState.UpdateTimeStamp();
-		if(!OutStates.Find(RenamedState.GetFilename()))
-			OutStates.Add(RenamedState.GetFilename(), MoveTemp(RenamedState));
-		break;
+		// The original path of a rename is the record following it
+		if(bExpectOriginalPath)
+		{
+			bExpectOriginalPath = false;
+			AddRename(Record);
+			return;
+		}
+
+		if(Record.Len() < 3 || Record[1] != ' ')
+			return;
+
+		const ANSICHAR EntryType = Record[0];
+		Record = FAnsiStringView(Record.GetData() + 2, Record.Len() - 2);
+
+		switch(EntryType)
+		{
+		case '1':
+		case '2':
+		{
+			FAnsiStringView XY, Submodule, HeadObject, IndexObject;
+			if(!NextStatusField(Record, XY) || XY.Len() != 2 || !NextStatusField(Record, Submodule) || !SkipStatusFields(Record, 3)
+				|| !NextStatusField(Record, HeadObject) || !NextStatusField(Record, IndexObject))
+				return;
+
+			if(EntryType == '2')
+			{
+				// The renamed path is known first, but the state is keyed on the original path
+				if(!SkipStatusFields(Record, 1))
+					return;
+
+				PendingIndexState = XY[0];
+				PendingWCopyState = XY[1];
+				PendingState = FGitSourceControlState(MakeAbsolutePath(RepositoryRoot, Record));
+				ParseSubmoduleField(Submodule, PendingState);
+				ParseObjectId(HeadObject, PendingState.HeadObjectId);
+				ParseObjectId(IndexObject, PendingState.IndexObjectId);
+				bExpectOriginalPath = true;
+				return;
+			}
+
+			FGitSourceControlState State(MakeAbsolutePath(RepositoryRoot, Record));
+			ParseSubmoduleField(Submodule, State);
+			ParseObjectId(HeadObject, State.HeadObjectId);
+			ParseObjectId(IndexObject, State.IndexObjectId);
+			ApplyStatusCode(XY[0], XY[1], State);
+			AddState(MoveTemp(State));
+			break;
+		}
+		case 'u':
+		{
+			// Unmerged entries have the objects of each stage instead of head and index
+			FAnsiStringView XY, Submodule;
+			if(!NextStatusField(Record, XY) || XY.Len() != 2 || !NextStatusField(Record, Submodule) || !SkipStatusFields(Record, 7))
+				return;
+
+			FGitSourceControlState State(MakeAbsolutePath(RepositoryRoot, Record));
+			ParseSubmoduleField(Submodule, State);
+			ApplyStatusCode(XY[0], XY[1], State);
+			AddState(MoveTemp(State));
+			break;
+		}
+		case '?':
+		case '!':
+		{
+			FGitSourceControlState State(MakeAbsolutePath(RepositoryRoot, Record));
+			ApplyStatusCode(EntryType, EntryType, State);
+			AddState(MoveTemp(State));
+			break;
+		}
+		default:
+			// '#' headers are only output with --branch, they are not used
+			break;
+		}
 	}
-	case TEXT('U'):
-		State.WorkingCopyState = EWorkingCopyState::Conflicted;
-		break;
-	case TEXT('C'): //Copy is not handled but this means the file has not changed ?
-	case TEXT('X'):
-	case TEXT('B'):
-	default:
-		State.WorkingCopyState = EWorkingCopyState::Unknown;
+
+private:
+	void AddRename(FAnsiStringView InOriginalPath)
+	{
+		//Note: same behavior as porcelain v1, the original path is deleted and the new one is not controlled until the rename is committed
+		FGitSourceControlState State(MakeAbsolutePath(RepositoryRoot, InOriginalPath));
+		State.HeadObjectId = PendingState.HeadObjectId;
+		if(ApplyStatusCode(PendingIndexState, PendingWCopyState, State))
+		{
+			PendingState.HeadObjectId = FSHAHash();
+			PendingState.WorkingCopyState = EWorkingCopyState::NotControlled;
+			PendingState.UpdateTimeStamp();
+			if(!States.Find(PendingState.GetFilename()))
+				States.Add(PendingState.GetFilename(), MoveTemp(PendingState));
+		}
+		AddState(MoveTemp(State));
 	}
 
-	State.UpdateTimeStamp();
-	OutStates.Add(State.GetFilename(), MoveTemp(State));
+	void AddState(FGitSourceControlState&& InState)
+	{
+		InState.UpdateTimeStamp();
+		States.Add(InState.GetFilename(), MoveTemp(InState));
+	}
+
+	const FString& RepositoryRoot;
+	TMap<FString, FGitSourceControlState>& States;
+
+	/** Rename entry waiting for its original path */
+	bool bExpectOriginalPath;
+	ANSICHAR PendingIndexState;
+	ANSICHAR PendingWCopyState;
+	FGitSourceControlState PendingState;
+};
+
+/**
+ * Parser of the NUL separated records of 'git diff --name-status -z' or 'git log --name-status -z', fed one record at a time.
+ * The status and each path are separate records, renames and copies are followed by two paths.
+ * For full syntax see git help diff, look for diff-filter
+ *
+ * Example results, with \0 as line breaks
+R100
+dir/before_rename.txt
+dir/after_rename.txt
+A
+dir/added_file.txt
+M
+modified_file.txt
+*/
+class FNameStatusParser
+{
+public:
+	FNameStatusParser(const FString& InRepositoryRoot, TMap<FString, FGitSourceControlState>& InOutStates)
+		: RepositoryRoot(InRepositoryRoot)
+		, States(InOutStates)
+		, StatusCode(0)
+		, PathsExpected(0)
+	{
+	}
+
+	void ParseRecord(const ANSICHAR* InData, int32 InSize)
+	{
+		FAnsiStringView Record(InData, InSize);
+
+		if(PathsExpected == 0)
+		{
+			if(Record.Len() == 0)
+				return;
+
+			StatusCode = Record[0];
+			PathsExpected = (StatusCode == 'R' || StatusCode == 'C') ? 2 : 1;
+			return;
+		}
+
+		--PathsExpected;
+		if(PathsExpected == 1)
+		{
+			// Source of a rename or copy, wait for the destination
+			PendingFilename = MakeAbsolutePath(RepositoryRoot, Record);
+			return;
+		}
+
+		const bool bHasSource = StatusCode == 'R' || StatusCode == 'C';
+		FGitSourceControlState State(bHasSource ? MoveTemp(PendingFilename) : MakeAbsolutePath(RepositoryRoot, Record));
+
+		switch(StatusCode)
+		{
+		case ' ':
+			State.WorkingCopyState = EWorkingCopyState::Unchanged;
+			break;
+		case 'T':
+		case 'M':
+			State.WorkingCopyState = EWorkingCopyState::Modified;
+			break;
+		case 'A':
+			State.WorkingCopyState = EWorkingCopyState::Added;
+			break;
+		case 'D':
+			State.WorkingCopyState = EWorkingCopyState::Deleted;
+			break;
+		case 'R':
+		{
+			State.WorkingCopyState = EWorkingCopyState::Deleted;
+
+			FGitSourceControlState RenamedState(MakeAbsolutePath(RepositoryRoot, Record));
+			RenamedState.WorkingCopyState = EWorkingCopyState::Added;
+			RenamedState.UpdateTimeStamp();
+			if(!States.Find(RenamedState.GetFilename()))
+				States.Add(RenamedState.GetFilename(), MoveTemp(RenamedState));
+			break;
+		}
+		case 'U':
+			State.WorkingCopyState = EWorkingCopyState::Conflicted;
+			break;
+		case 'C': //Copy is not handled but this means the file has not changed ?
+		case 'X':
+		case 'B':
+		default:
+			State.WorkingCopyState = EWorkingCopyState::Unknown;
+		}
+
+		State.UpdateTimeStamp();
+		States.Add(State.GetFilename(), MoveTemp(State));
+	}
+
+private:
+	const FString& RepositoryRoot;
+	TMap<FString, FGitSourceControlState>& States;
+
+	/** Status of the entry being parsed */
+	ANSICHAR StatusCode;
+
+	/** Path records left for the entry being parsed */
+	int32 PathsExpected;
+
+	/** Source path of a rename or copy */
+	FString PendingFilename;
 };
 
-/** Interpret the line from a git lfs locks command and return a FGitSourceControlState */
-static void ParseLocksLine(const FString& InLine, const FString& InRepositoryRoot, const FString& LocalUserName, TMap<FString, FGitSourceControlState>& OutStates)
+/** Interpret the line from a git lfs locks command and return a FGitSourceControlState
+ *
+ * Example results from the documentation:
+$ git lfs locks
+images/bar.jpg  jane   ID:123
+images/foo.jpg  alice  ID:456
+*/
+static void ParseLocksLine(FStringView InLine, const FString& InRepositoryRoot, const FString& LocalUserName, TMap<FString, FGitSourceControlState>& OutStates)
 {
 	if (InLine.Len() < 2)
 		return;
 
 	// Extract the relative filename from the Git status result
 	// There are no quotes here even if the file path has spaces
-	FString RelativeFilename;
-	FString LockOwner;
+	FStringView RelativeFilename;
+	FStringView LockOwner;
 	int LockId = -1;
-	int32 TabIndex = INDEX_NONE;
 	bool bParseSuccess = false;
-	if (InLine.FindChar('\t', TabIndex))
+	const int32 TabIndex = FindCharInView(InLine, '\t');
+	if (TabIndex != INDEX_NONE)
 	{
-		RelativeFilename = InLine.Left(TabIndex);
-		RelativeFilename.TrimEndInline(); //The line may contain spaces and not only tabs
-		LockOwner = InLine.Mid(TabIndex + 1);
+		RelativeFilename = TrimView(SubView(InLine, 0, TabIndex)); //The line may contain spaces and not only tabs
+		LockOwner = SubView(InLine, TabIndex + 1);
 
-		int IdIndex = INDEX_NONE;
-		if (LockOwner.FindLastChar(TCHAR(':'), IdIndex))
+		const int32 IdIndex = FindLastCharInView(LockOwner, TCHAR(':'));
+		if (IdIndex != INDEX_NONE)
 		{
-			LockId = FCString::Atoi(&LockOwner.GetCharArray()[IdIndex + 1]);
-
-			int32 SecondTabIndex = INDEX_NONE;
-			if (LockOwner.FindChar('\t', SecondTabIndex))
+			const FStringView LockIdView = SubView(LockOwner, IdIndex + 1);
+			TCHAR LockIdBuffer[32];
+			const int32 LockIdLen = FMath::Min(LockIdView.Len(), (int32)UE_ARRAY_COUNT(LockIdBuffer) - 1);
+			FMemory::Memcpy(LockIdBuffer, LockIdView.GetData(), LockIdLen * sizeof(TCHAR));
+			LockIdBuffer[LockIdLen] = 0;
+			LockId = FCString::Atoi(LockIdBuffer);
+
+			const int32 SecondTabIndex = FindCharInView(LockOwner, '\t');
+			if (SecondTabIndex != INDEX_NONE)
 			{
-				LockOwner = LockOwner.Left(SecondTabIndex);
-				LockOwner.TrimStartAndEndInline();
+				LockOwner = TrimView(SubView(LockOwner, 0, SecondTabIndex));
 				bParseSuccess = true;
 			}
 		}
@@ -739,32 +1695,20 @@ static void ParseLocksLine(const FString& InLine, const FString& InRepositoryRoo
 		return;
 
 	//Restore absolute path in the state
-	FGitSourceControlState State(FPaths::Combine(InRepositoryRoot, RelativeFilename));
+	FGitSourceControlState State(MakeAbsolutePath(InRepositoryRoot, RelativeFilename));
 
-	State.UserLocked = LockOwner;
-	State.bLockedByOther = LockOwner != LocalUserName;
+	State.UserLocked = FString(LockOwner.Len(), LockOwner.GetData());
+	State.bLockedByOther = State.UserLocked != LocalUserName;
 	State.LockId = LockId;
 
 	OutStates.Add(State.GetFilename(), MoveTemp(State));
 }
 
-/** Parse the array of strings results of a 'git status' command
- *
- * Example git status results:
-M  Content/Textures/T_Perlin_Noise_M.uasset
-R  Content/Textures/T_Perlin_Noise_M.uasset -> Content/Textures/T_Perlin_Noise_M2.uasset
-?? Content/Materials/M_Basic_Wall.uasset
-!! BasicCode.sln
-*/
-void ParseStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, const TArray<FString>& InResults, TMap<FString, FGitSourceControlState>& OutStates)
+/**
+ * Git status does not report unchanged files, add a state for all files explicitly listed in the command that did not get one
+ */
+static void CompleteStatusResults(const TArray<FString>& InFiles, TMap<FString, FGitSourceControlState>& OutStates)
 {
-	// Iterate on results first
-	for(const auto& Line : InResults)
-	{
-		ParseStatusLine(Line, InRepositoryRoot, OutStates);
-	}
-
-	// Iterate on all files explicitly listed in the command to check if we have a state for them
 	for(const auto& File : InFiles)
 	{
 		auto FileInfo = FPlatformFileManager::Get().GetPlatformFile().GetStatData(*File);
@@ -788,87 +1732,259 @@ void ParseStatusResults(const FString& InPathToGitBinary, const FString& InRepos
 
 			FileState.UpdateTimeStamp();
 
-			OutStates.Add(File, FileState);
+			OutStates.Add(File, MoveTemp(FileState));
 		}
 	}
 }
 
-/** Parse the array of strings results of a 'git diff --name-status' or 'git log --name-status' command
- *
- * Example results, for full syntax see git help diff, look for diff-filter
-R100    dir/before_rename.txt     dir/after_rename.txt
-A       dir/added_file.txt
-M       modified_file.txt
-*/
-void ParseNameStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InResults, TMap<FString, FGitSourceControlState>& OutStates)
+// Run a Git "status" command and parse it, using the NUL separated porcelain v2 format when available
+bool RunStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TMap<FString, FGitSourceControlState>& OutStates, TArray<FString>& OutErrorMessages)
 {
-	// Iterate on results first
-	for(const auto& Line : InResults)
+	if(GitCapabilities::bSupportsStatusV2)
 	{
-		ParseNameStatusLine(Line, InRepositoryRoot, OutStates);
+		FStatusV2Parser Parser(InRepositoryRoot, OutStates);
+		return RunCommandRecords(TEXT("status --porcelain=v2 -z"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, '\0',
+			[&Parser](const ANSICHAR* InData, int32 InSize) { Parser.ParseRecord(InData, InSize); }, OutErrorMessages);
 	}
+
+	return RunCommandStreamed(TEXT("status --porcelain"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles,
+		[&](FStringView InLine) { ParseStatusLine(InLine, InRepositoryRoot, OutStates); }, OutErrorMessages);
 }
 
-/** Parse the array of strings results of a 'git lfs locks' command
- *
- * Example results from the documentation:
-$ git lfs locks
-images/bar.jpg  jane   ID:123
-images/foo.jpg  alice  ID:456
-*/
-static void ParseLocksResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InResults, TMap<FString, FGitSourceControlState>& OutStates)
+// Run a Git "diff --name-status" command and parse it
+bool RunNameStatusDiff(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TMap<FString, FGitSourceControlState>& OutStates, TArray<FString>& OutErrorMessages)
+{
+	FNameStatusParser Parser(InRepositoryRoot, OutStates);
+	return RunCommandRecords(TEXT("diff --name-status -z"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, '\0',
+		[&Parser](const ANSICHAR* InData, int32 InSize) { Parser.ParseRecord(InData, InSize); }, OutErrorMessages);
+}
+
+/** The name lfs reports for locks owned by the local user */
+static FString GetLocalLockingUserName()
 {
 	auto& Module = FGitSourceControlModule::GetInstance();
 	const FString& LockingUserName = Module.AccessSettings().GetLockingUsername();
-	const FString& UserName = Module.GetProvider().GetUserName();
-	// Iterate on results first
-	for (const auto& Line : InResults)
-	{
-		ParseLocksLine(Line, InRepositoryRoot, LockingUserName.IsEmpty() ? UserName : LockingUserName, OutStates);
-	}
+	return LockingUserName.IsEmpty() ? Module.GetProvider().GetUserName() : LockingUserName;
 }
 
 // Returns the full commit SHA for logical name or empty string
 FString GetCommitShaForBranch(const FString& InBranch, const FString& InPathToGitBinary, const FString& InRepositoryRoot)
 {
-	TArray<FString> StdOut;
-	TArray<FString> StdErr;
-	TArray<FString> Parameters;
-	Parameters.Add(InBranch);
-	bool bResult = RunCommand(TEXT("rev-parse --verify"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
-	if(bResult && StdOut.Num() == 1)
-		return StdOut[0];
-	else
-		return FString();
+	FGitRefResolutionCache* RefCache = GetRefResolutionCache(InRepositoryRoot);
+	FString Sha;
+	if(RefCache && RefCache->FindCommitSha(InBranch, Sha))
+	{
+		return Sha;
+	}
+
+	// Ask the persistent cat-file process first, only spawn git if it could not answer
+	FString Type;
+	int64 Size = 0;
+	FGitCatFileBatch& CatFile = FGitSourceControlModule::GetInstance().GetProvider().GetCatFileBatch();
+	const EGitCatFileResult::Type Result = CatFile.GetObjectInfo(InPathToGitBinary, InRepositoryRoot, InBranch, Sha, Type, Size);
+	if(Result == EGitCatFileResult::Missing)
+	{
+		Sha.Empty();
+	}
+	else if(Result == EGitCatFileResult::Failed)
+	{
+		TArray<FString> StdOut;
+		TArray<FString> StdErr;
+		TArray<FString> Parameters;
+		Parameters.Add(InBranch);
+		bool bResult = RunCommand(TEXT("rev-parse --verify"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
+		if(bResult && StdOut.Num() == 1)
+			Sha = StdOut[0];
+		else
+			Sha.Empty();
+	}
+
+	if(RefCache)
+	{
+		RefCache->AddCommitSha(InBranch, Sha);
+	}
+	return Sha;
 }
 
 FString GetMergeBase(const FString& InCommit1, const FString& InCommit2, const FString& InPathToGitBinary, const FString& InRepositoryRoot)
 {
-	TArray<FString> StdOut;
-	TArray<FString> StdErr;
-	TArray<FString> Parameters;
-	Parameters.Add(InCommit1);
-	Parameters.Add(InCommit2);
-	const bool bResult = RunCommand(TEXT("merge-base"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
-	if(!bResult || StdOut.Num() == 0)
+	FGitRefResolutionCache* RefCache = GetRefResolutionCache(InRepositoryRoot);
+	FString MergeBase;
+	if(RefCache && RefCache->FindMergeBase(InCommit1, InCommit2, MergeBase))
 	{
-		return FString();
+		return MergeBase;
 	}
-	else
+
+	const FString Sha1 = GetCommitShaForBranch(InCommit1, InPathToGitBinary, InRepositoryRoot);
+	const FString Sha2 = GetCommitShaForBranch(InCommit2, InPathToGitBinary, InRepositoryRoot);
+	FGitCommitGraph& CommitGraph = FGitSourceControlModule::GetInstance().GetProvider().GetCommitGraph();
+	const bool bFoundInGraph = !Sha1.IsEmpty() && !Sha2.IsEmpty() && CommitGraph.AddCommits(InPathToGitBinary, InRepositoryRoot, { Sha1, Sha2 })
+		&& CommitGraph.FindMergeBase(InRepositoryRoot, Sha1, Sha2, MergeBase);
+
+	if(!bFoundInGraph)
+	{
+		TArray<FString> StdOut;
+		TArray<FString> StdErr;
+		TArray<FString> Parameters;
+		Parameters.Add(InCommit1);
+		Parameters.Add(InCommit2);
+		const bool bResult = RunCommand(TEXT("merge-base"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
+		if(bResult && StdOut.Num() > 0)
+		{
+			MergeBase = StdOut[0];
+		}
+	}
+
+	if(RefCache)
+	{
+		RefCache->AddMergeBase(InCommit1, InCommit2, MergeBase);
+	}
+	return MergeBase;
+}
+
+bool IsAncestor(const FString& InAncestor, const FString& InCommit, const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	FGitRefResolutionCache* RefCache = GetRefResolutionCache(InRepositoryRoot);
+	bool bIsAncestor = false;
+	if(RefCache && RefCache->FindIsAncestor(InAncestor, InCommit, bIsAncestor))
+	{
+		return bIsAncestor;
+	}
+
+	const FString AncestorSha = GetCommitShaForBranch(InAncestor, InPathToGitBinary, InRepositoryRoot);
+	const FString CommitSha = GetCommitShaForBranch(InCommit, InPathToGitBinary, InRepositoryRoot);
+	FGitCommitGraph& CommitGraph = FGitSourceControlModule::GetInstance().GetProvider().GetCommitGraph();
+	const bool bFoundInGraph = !AncestorSha.IsEmpty() && !CommitSha.IsEmpty() && CommitGraph.AddCommits(InPathToGitBinary, InRepositoryRoot, { AncestorSha, CommitSha })
+		&& CommitGraph.IsAncestor(InRepositoryRoot, AncestorSha, CommitSha, bIsAncestor);
+
+	if(!bFoundInGraph)
+	{
+		TArray<FString> StdOut;
+		TArray<FString> StdErr;
+		bIsAncestor = RunCommand(TEXT("merge-base --is-ancestor"), InPathToGitBinary, InRepositoryRoot, { InAncestor, InCommit }, TArray<FString>(), StdOut, StdErr);
+	}
+
+	if(RefCache)
 	{
-		return StdOut[0];
+		RefCache->AddIsAncestor(InAncestor, InCommit, bIsAncestor);
+	}
+	return bIsAncestor;
+}
+
+// Get the changes on the remote branch since the merge-base, reusing the diff cached by previous commands
+bool GetRemoteDiff(const FGitSourceControlCommand& InCommand, const FString& InMergeBase, const FString& InRemoteSha, FGitStateMapPtr& OutRemoteStates, TArray<FString>& OutErrorMessages)
+{
+	if(InRemoteSha == InMergeBase)
+	{
+		OutRemoteStates = MakeShared<const FGitStateMap, ESPMode::ThreadSafe>();
+		return true;
+	}
+
+	FGitRemoteDiffCache& Cache = FGitSourceControlModule::GetInstance().GetProvider().GetRemoteDiffCache();
+	OutRemoteStates = Cache.Find(InCommand.PathToRepositoryRoot, InMergeBase, InRemoteSha);
+	if(OutRemoteStates.IsValid())
+	{
+		GITCENTRAL_VERBOSE(TEXT("GetRemoteDiff: %s..%s from cache"), *InMergeBase, *InRemoteSha);
+		return true;
+	}
+
+	//Note: the cached diff is only extended when the remote branch moved forward, a force push may have dropped some of its changes
+	FString CachedRemoteSha;
+	FGitStateMapPtr CachedStates = Cache.FindForMergeBase(InCommand.PathToRepositoryRoot, InMergeBase, CachedRemoteSha);
+	if(CachedStates.IsValid() && IsAncestor(CachedRemoteSha, InRemoteSha, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot))
+	{
+		FGitStateMap Increment;
+		if(!RunNameStatusDiff(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, { CachedRemoteSha, InRemoteSha }, TArray<FString>(), Increment, OutErrorMessages))
+		{
+			return false;
+		}
+
+		FGitStateMap Extended;
+		if(FGitRemoteDiffCache::Extend(*CachedStates, Increment, Extended))
+		{
+			GITCENTRAL_VERBOSE(TEXT("GetRemoteDiff: extended %s..%s with %d changes up to %s"), *InMergeBase, *CachedRemoteSha, Increment.Num(), *InRemoteSha);
+			OutRemoteStates = MakeShared<const FGitStateMap, ESPMode::ThreadSafe>(MoveTemp(Extended));
+			Cache.Add(InCommand.PathToRepositoryRoot, InMergeBase, InRemoteSha, OutRemoteStates);
+			return true;
+		}
+		GITCENTRAL_VERBOSE(TEXT("GetRemoteDiff: files changed again since %s, diffing %s..%s"), *CachedRemoteSha, *InMergeBase, *InRemoteSha);
+	}
+
+	FGitStateMap States;
+	if(!RunNameStatusDiff(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, { InMergeBase, InRemoteSha }, TArray<FString>(), States, OutErrorMessages))
+	{
+		return false;
+	}
+
+	OutRemoteStates = MakeShared<const FGitStateMap, ESPMode::ThreadSafe>(MoveTemp(States));
+	Cache.Add(InCommand.PathToRepositoryRoot, InMergeBase, InRemoteSha, OutRemoteStates);
+	return true;
+}
+
+// Find the last commit changing each file between the merge-base and the remote branch, in a single walk of the history
+// Note: merge commits do not list files, files only changed by a merge are missing from the result
+static bool GetLastChangedCommits(const FGitSourceControlCommand& InCommand, const FString& InMergeBase, const FString& InRemoteSha, TMap<FString, FString>& OutLastChangedCommits)
+{
+	TArray<FString> ErrorMessages;
+	FString CurrentCommit;
+	//Note: commits are prefixed by \x01 to tell them apart from paths, log outputs the newest commits first
+	const bool bResult = RunCommandRecords(TEXT("log --name-only -z"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, { TEXT("--format=%x01%H"), InMergeBase + TEXT("..") + InRemoteSha }, TArray<FString>(), '\0',
+		[&](const ANSICHAR* InData, int32 InSize)
+		{
+			FAnsiStringView Record(InData, InSize);
+			if(Record.Len() > 0 && Record[0] == '\x01')
+			{
+				CurrentCommit = FString(Record.Len() - 1, Record.GetData() + 1);
+				return;
+			}
+
+			// The first path of each commit follows the end of the format line
+			if(Record.Len() > 0 && Record[0] == '\n')
+			{
+				Record = FAnsiStringView(Record.GetData() + 1, Record.Len() - 1);
+			}
+			if(Record.Len() > 0 && !CurrentCommit.IsEmpty())
+			{
+				const FString File = MakeAbsolutePath(InCommand.PathToRepositoryRoot, Record);
+				if(!OutLastChangedCommits.Contains(File))
+				{
+					OutLastChangedCommits.Add(File, CurrentCommit);
+				}
+			}
+		}, ErrorMessages);
+
+	if(!bResult)
+	{
+		GITCENTRAL_ERROR(TEXT("Could not list the commits between %s and %s: %s"), *InMergeBase, *InRemoteSha, *FString::Join(ErrorMessages, TEXT("\n")));
+	}
+	return bResult;
+}
+
+// Find the commits reachable from a commit which are not reachable from the merge-base, which are all the commits of the remote range it contains
+static void GetCommitsSinceMergeBase(const FGitSourceControlCommand& InCommand, const FString& InCommit, const FString& InMergeBase, TSet<FString>& OutCommits)
+{
+	TArray<FString> ErrorMessages;
+	const bool bResult = RunCommandStreamed(TEXT("rev-list"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, { InCommit, TEXT("--not"), InMergeBase }, TArray<FString>(),
+		[&OutCommits](FStringView InLine)
+		{
+			OutCommits.Add(FString(InLine));
+		}, ErrorMessages);
+
+	if(!bResult)
+	{
+		//Note: the checked out revision may not be known locally, then no remote change is considered synced
+		GITCENTRAL_VERBOSE(TEXT("Could not list the commits of %s since %s: %s"), *InCommit, *InMergeBase, *FString::Join(ErrorMessages, TEXT("\n")));
+		OutCommits.Reset();
 	}
 }
 
 // Run a Git "status" command to update status of given files.
-bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates)
+bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates, FGitStateMapPtr InLocks)
 {
 	const FString& InRepositoryRoot = InCommand.PathToRepositoryRoot;
 	const FString& InPathToGitBinary = InCommand.PathToGitBinary;
 
-	bool bIsDirUpdate = false;
-
-	//files as parameters for most commands
+	//files and directories as parameters for most commands
 	TArray<FString> FilesParam;
 	FilesParam.Reserve(InFiles.Num());
 
@@ -876,6 +1992,10 @@ bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>&
 	TArray<FString> FilesToDiff;
 	FilesToDiff.Reserve(InFiles.Num());
 
+	//files and directories, queried separately as only directories need a scan of untracked files
+	TArray<FString> FilesOnlyParam;
+	TArray<FString> DirectoriesParam;
+
 	for(const auto& File : InFiles)
 	{
 		//Only include paths that belong to the selected git repository
@@ -888,9 +2008,12 @@ bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>&
 		FilesParam.Add(File);
 		if(FileInfo.bIsDirectory)
 		{
-			bIsDirUpdate = true;
+			DirectoriesParam.Add(File);
+			continue;
 		}
-		else if(FileInfo.bIsValid)// git diff only accepted existing filesystem paths
+
+		FilesOnlyParam.Add(File);
+		if(FileInfo.bIsValid)// git diff only accepted existing filesystem paths
 		{
 			FilesToDiff.Add(File);
 		}
@@ -899,19 +2022,6 @@ bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>&
 	if(!FilesParam.Num())
 		return false;
 
-	FString MergeBase;
-	const FString RemoteBranch = InCommand.GetRemoteBranch();
-
-	//Find merge base for local branch and remote
-	{
-		MergeBase = GetMergeBase(InCommand.Branch, RemoteBranch, InPathToGitBinary, InRepositoryRoot);
-		if(MergeBase.IsEmpty())
-		{
-			OutErrorMessages.Add(*FString::Printf(TEXT("Could not find merge-base for %s and %s"), *InCommand.Branch, *RemoteBranch));
-			return false;
-		}
-	}
-
 	//Strategy for status against remote server:
 	//Find best merge ancestor
 	//Log and aggregate all changes from ancestor to remote
@@ -921,246 +2031,650 @@ bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>&
 	//Add lfs lock status
 	//Compute final status based on all of this
 
+	//Note: git status and lfs locks only depend on the requested files, they run concurrently with the diffs which need the merge-base first.
+	//Each stage only writes its own results, they are combined in the original order once all of them are done.
+	const FString RemoteBranch = InCommand.GetRemoteBranch();
+
+	// Run regular git status to update local status
+	//We no longer get the status of ignored files
+	//Note: git status returns folders as well, when they are recently added and contain untracked files, with a not controlled status
+	// Using -u allows to see the untracked files instead of the folders, but folders will still appear 
+	TMap<FString, FGitSourceControlState> StatusStates;
+	TArray<FString> StatusErrors;
+
+	// Files unchanged according to the index are completed as unchanged like the files git status does not list, without running it
+	TArray<FString> FilesToStatus;
+	TArray<FString> UnchangedFiles;
+	FGitSourceControlModule::GetInstance().GetProvider().GetIndex().SplitUnchangedFiles(InPathToGitBinary, InRepositoryRoot, FilesOnlyParam, UnchangedFiles, FilesToStatus);
+
+	TFuture<bool> StatusStage;
+	if(FilesToStatus.Num())
+	{
+		StatusStage = RunCommandStage(InCommand, [&]()
+		{
+			return RunStatus(InPathToGitBinary, InRepositoryRoot, TArray<FString>(), FilesToStatus, StatusStates, StatusErrors);
+		});
+	}
+
+	//Directories must fetch the status of all untracked files (-u) otherwise status only returns the directory to be untracked
+	TMap<FString, FGitSourceControlState> DirectoryStatusStates;
+	TArray<FString> DirectoryStatusErrors;
+	TFuture<bool> DirectoryStatusStage;
+	if(DirectoriesParam.Num())
+	{
+		DirectoryStatusStage = RunCommandStage(InCommand, [&]()
+		{
+			return RunStatus(InPathToGitBinary, InRepositoryRoot, { TEXT("-u") }, DirectoriesParam, DirectoryStatusStates, DirectoryStatusErrors);
+		});
+	}
+
+	// Get the lfs locks, the slowest stage as it asks the LFS server
+	FGitStateMapPtr LockStatesPtr = InLocks;
+	TArray<FString> LockErrors;
+	TFuture<bool> LocksStage;
+	if(InCommand.bUseLocking && !LockStatesPtr.IsValid() && FilesToStatus.Num() == 0 && DirectoriesParam.Num() == 0)
+	{
+		//Note: no git process runs for files answered by the index, the LFS server is not asked either as long as the locks are recent
+		LockStatesPtr = FGitSourceControlModule::GetInstance().GetProvider().GetLockCache().Find(InRepositoryRoot, GitSourceControlConstants::MaxLockCacheAge);
+	}
+	if(InCommand.bUseLocking && !LockStatesPtr.IsValid())
+	{
+		LocksStage = RunCommandStage(InCommand, [&]()
+		{
+			return RunGetLocks(InCommand, LockStatesPtr, LockErrors);
+		});
+	}
+
 	TMap<FString, FGitSourceControlState> States;
 
+	//Find merge base for local branch and remote
+	const FString MergeBase = GetMergeBase(InCommand.Branch, RemoteBranch, InPathToGitBinary, InRepositoryRoot);
+	bool bDiffsResult = !MergeBase.IsEmpty();
+	if(!bDiffsResult)
+	{
+		OutErrorMessages.Add(*FString::Printf(TEXT("Could not find merge-base for %s and %s"), *InCommand.Branch, *RemoteBranch));
+	}
 
-	// Get all the remote diffs since merge-base
-	// We do this first to add files which may not have a local status but have one remotely
-	// Optimization : We could not run this command if we already know files are up to date
-	const FString RemoteBranchSha = GetCommitShaForBranch(RemoteBranch, InPathToGitBinary, InRepositoryRoot);
-	TMap<FString, FGitSourceControlState> RemoteStates;
+	// Get all the locally commited diffs since merge-base
+	const FString LocalBranchSha = bDiffsResult ? GetCommitShaForBranch(InCommand.Branch, InPathToGitBinary, InRepositoryRoot) : FString();
+	TFuture<bool> LocalDiffStage;
+	if(bDiffsResult && (FilesToDiff.Num() || DirectoriesParam.Num()) && LocalBranchSha != MergeBase)
+	{
+		//Directories are diffed as a whole
+		FilesToDiff.Append(DirectoriesParam);
 
-	if(RemoteBranchSha != MergeBase)
+		LocalDiffStage = RunCommandStage(InCommand, [&]()
+		{
+			TArray<FString> StdErr;
+			return RunNameStatusDiff(InPathToGitBinary, InRepositoryRoot, { MergeBase, InCommand.Branch }, FilesToDiff, States, StdErr);
+		});
+	}
+
+	// Get all the remote diffs since merge-base
+	// Files which may not have a local status but have one remotely are added once all the stages are done
+	const FString RemoteBranchSha = bDiffsResult ? GetCommitShaForBranch(RemoteBranch, InPathToGitBinary, InRepositoryRoot) : FString();
+	FGitStateMapPtr RemoteStatesPtr;
+	if(bDiffsResult)
 	{
-		TArray<FString> StdOut;
-		TArray<FString> StdErr;
-		TArray<FString> Parameters;
-		Parameters.Add(MergeBase);
-		Parameters.Add(RemoteBranch);
 		//diff all files from the server but will only keep states that we are interested in
 		//TODO: Maybe this would be better with a log and aggregating what happened as we can miss some add+delete cases with git diff
 		//git log --name-status --pretty=format:"> %h %s" --reverse
-		bool bRemoteStatusResult = RunCommand(TEXT("diff --name-status"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
-		if(bRemoteStatusResult)
+		TArray<FString> StdErr;
+		bDiffsResult = GetRemoteDiff(InCommand, MergeBase, RemoteBranchSha, RemoteStatesPtr, StdErr);
+	}
+
+	// The stages reference the locals of this function, always wait for all of them
+	const bool bLocalDiffResult = WaitForCommandStage(LocalDiffStage);
+	const bool bStatusResult = WaitForCommandStage(StatusStage);
+	const bool bDirectoryStatusResult = WaitForCommandStage(DirectoryStatusStage);
+	const bool bLocksResult = WaitForCommandStage(LocksStage);
+	OutErrorMessages.Append(StatusErrors);
+	OutErrorMessages.Append(DirectoryStatusErrors);
+	OutErrorMessages.Append(LockErrors);
+	if(!bDiffsResult || !bLocalDiffResult || !bStatusResult || !bDirectoryStatusResult || !bLocksResult)
+	{
+		return false;
+	}
+	const FGitStateMap& RemoteStates = *RemoteStatesPtr;
+
+	// Add all relevant files from remote to file list: the ones in the requested directories, already covered by their status
+	if(DirectoriesParam.Num())
+	{
+		for(const auto& RemoteState : RemoteStates)
 		{
-			ParseNameStatusResults(InPathToGitBinary, InRepositoryRoot, StdOut, RemoteStates);
+			const FString& File = RemoteState.Value.GetFilename();
+			if(DirectoriesParam.ContainsByPredicate([&File](const FString& Directory) { return File.StartsWith(Directory / TEXT("")); }))
+			{
+				FilesParam.Add(File);
+			}
+		}
+	}
+
+	{
+		StatusStates.Append(MoveTemp(DirectoryStatusStates));
+		CompleteStatusResults(FilesParam, StatusStates);
+
+		//Note: conflict here is not handled well, we assume normal operation will not generate local conflicts
 
-			if(bIsDirUpdate)
+		//Local states are added and combined to regular statuses
+		for(auto& It : StatusStates)
+		{
+			FGitSourceControlState* StateResult = States.Find(It.Key);
+			if(StateResult)
+			{
+				//Combine local state with more recent status state
+				StateResult->CombineWithLocalState(It.Value);
+			}
+			else
 			{
-				for(const auto& RemoteState : RemoteStates)
+				States.Add(It.Key, MoveTemp(It.Value));
+			}
+		}
+	}
+
+	//Note: we are not parsing the status file for deleted files if they haven't changed on the server or locally they are not relevant for the status update
+	//do not take into account checked out revision to create conflict on deletion because otherwise we can never submit the deletion!
+
+	// Get all the saved states before applying remote diffs
+	FGitSourceControlModule& GitSourceControl = FGitSourceControlModule::GetInstance();
+	FGitSourceControlStatusFile& StatusFile = GitSourceControl.GetStatusFile();
+	for(auto& It : States)
+	{
+		const FString& File = It.Value.GetFilename();
+		const auto& SavedState = StatusFile.GetState(File);
+		It.Value.CombineWithSavedState(SavedState, LocalBranchSha);
+
+		//Check on disk for accurate deleted state no matter what are the conditions
+		//Note: Fix for newly created assets, if something didn't have a status at all and doesn't exist on disk it's probably not deleted
+		if(It.Value.WorkingCopyState != EWorkingCopyState::Unknown)
+		{
+			//Note: git status returns folders as well, when they are recently added and contain untracked files, with a not controlled status
+			FFileStatData FileInfo = FPlatformFileManager::Get().GetPlatformFile().GetStatData(*File);
+			if (!FileInfo.bIsValid)//File or folder doesn't exist
+			{
+				It.Value.WorkingCopyState = EWorkingCopyState::Deleted;
+			}
+		}
+	}
+
+	//Note: a file that has been added on remote, checked out locally, then deleted on remote will show as checked out instead of conflicted
+	//This is a rare case for now not handled, as it is equivalent to adding a new file again.
+
+	//Process remote states
+	if(RemoteStates.Num())
+	{
+		//Note: computed once on demand for all the outdated files, instead of a log and a merge-base per file
+		TMap<FString, FString> LastChangedCommits;
+		bool bLastChangedCommitsLoaded = false;
+		TSet<FString> IndexedRevisions;
+		TMap<FString, TSet<FString>> CommitsByCheckedOutRevision;
+		FGitCommitGraph& CommitGraph = FGitSourceControlModule::GetInstance().GetProvider().GetCommitGraph();
+
+		for(const auto& It : RemoteStates)
+		{
+			FGitSourceControlState* StateResult = States.Find(It.Key);
+			if(!StateResult) //States have all been created by RunStatus
+				continue;
+
+			//Note: if OldState == Deleted, we should not care about checked-out revision and always accept the conflict
+			EWorkingCopyState::Type OldState = StateResult->WorkingCopyState;
+			//Combine local state with "more recent" remote state
+			StateResult->CombineWithRemoteState(It.Value);
+
+			//Resolve outdated or conflict when applicable
+			if(!StateResult->IsCurrent() && StateResult->CheckedOutRevision != "0")
+			{
+				if(StateResult->CheckedOutRevision == RemoteBranchSha)
 				{
-					FilesParam.Add(RemoteState.Value.GetFilename());
+					StateResult->ResolveConflict(OldState);
+				}
+				else
+				{
+					if(!bLastChangedCommitsLoaded)
+					{
+						bLastChangedCommitsLoaded = true;
+						GetLastChangedCommits(InCommand, MergeBase, RemoteBranchSha, LastChangedCommits);
+					}
+
+					//Last changed revision must be an ancestor of CheckedOutReivision
+					if(const FString* LastChangedRev = LastChangedCommits.Find(It.Key))
+					{
+						const FString& CheckedOutRevision = StateResult->CheckedOutRevision;
+						if(!IndexedRevisions.Contains(CheckedOutRevision))
+						{
+							IndexedRevisions.Add(CheckedOutRevision);
+							CommitGraph.AddCommits(InPathToGitBinary, InRepositoryRoot, { RemoteBranchSha, CheckedOutRevision });
+						}
+
+						bool bIsAncestor = false;
+						if(!CommitGraph.IsAncestor(InRepositoryRoot, *LastChangedRev, CheckedOutRevision, bIsAncestor))
+						{
+							TSet<FString>* CheckedOutCommits = CommitsByCheckedOutRevision.Find(CheckedOutRevision);
+							if(!CheckedOutCommits)
+							{
+								CheckedOutCommits = &CommitsByCheckedOutRevision.Add(CheckedOutRevision);
+								GetCommitsSinceMergeBase(InCommand, CheckedOutRevision, MergeBase, *CheckedOutCommits);
+							}
+							bIsAncestor = CheckedOutCommits->Contains(*LastChangedRev);
+						}
+
+						if(bIsAncestor)
+						{
+							StateResult->ResolveConflict(OldState);
+						}
+					}
+					else
+					{
+						TArray<FString> StdOut;
+						TArray<FString> StdErr;
+						//Get the latest revision at which the file was changed on remote
+						const bool bResult = RunCommand(TEXT("log --pretty=format:\"%H\" -1 "), InPathToGitBinary, InRepositoryRoot, { RemoteBranch }, { It.Key }, StdOut, StdErr);
+						if(bResult && StdOut.Num() == 1)
+						{
+							const FString& LastChangedRev = StdOut[0];
+							if(IsAncestor(LastChangedRev, StateResult->CheckedOutRevision, InPathToGitBinary, InRepositoryRoot))
+							{
+								StateResult->ResolveConflict(OldState);
+							}
+						}
+					}
 				}
 			}
 		}
-		else
+	}
+
+	//Process locks
+	if (InCommand.bUseLocking && LockStatesPtr.IsValid())
+	{
+		//Combine Lock States
+		for (const auto& It : *LockStatesPtr) //All locks state are locked, no need to test it here
 		{
-			return false;
+			FGitSourceControlState* StateResult = States.Find(It.Key);
+			if (StateResult)
+			{
+				StateResult->CombineWithLockedState(It.Value);
+			}
 		}
 	}
 
-	// Get all the locally commited diffs since merge-base
-	const FString LocalBranchSha = GetCommitShaForBranch(InCommand.Branch, InPathToGitBinary, InRepositoryRoot);
-	if((FilesToDiff.Num() || bIsDirUpdate) && LocalBranchSha != MergeBase)
+	//Generate value array to return
+	TArray<FGitSourceControlState> OutStatesIteration;
+	States.GenerateValueArray(OutStatesIteration);
+	OutStates.Append(OutStatesIteration);
+
+	return true;
+}
+
+bool RunGetLocks(const FGitSourceControlCommand& InCommand, FGitStateMapPtr& OutLocks, TArray<FString>& OutErrorMessages)
+{
+	FGitLockCache& LockCache = FGitSourceControlModule::GetInstance().GetProvider().GetLockCache();
+	const uint32 Generation = LockCache.GetGeneration();
+
+	const FString LocalUserName = GetLocalLockingUserName();
+	FGitStateMap Locks;
+	const bool bResult = RunCommandStreamed(TEXT("lfs locks -r"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, { InCommand.Remote }, TArray<FString>(),
+		[&](FStringView InLine) { ParseLocksLine(InLine, InCommand.PathToRepositoryRoot, LocalUserName, Locks); }, OutErrorMessages);
+	OutLocks = MakeShared<const FGitStateMap, ESPMode::ThreadSafe>(MoveTemp(Locks));
+	if(bResult)
 	{
-		//During directory updates we must check everything
-		if(bIsDirUpdate)
-			FilesToDiff.Reset();
+		LockCache.Add(InCommand.PathToRepositoryRoot, Generation, OutLocks);
+	}
+	return bResult;
+}
 
-		TArray<FString> StdOut;
-		TArray<FString> StdErr;
-		TArray<FString> Parameters;
-		Parameters.Add(MergeBase);
-		Parameters.Add(InCommand.Branch);
-		bool bResult = RunCommand(TEXT("diff --name-status"), InPathToGitBinary, InRepositoryRoot, Parameters, FilesToDiff, StdOut, StdErr);
-		if(bResult)
+void GetFilesWithChangedLocks(const FGitStateMap& InLocks, TArray<FString>& OutFiles)
+{
+	TMap<FString, int32> CachedLockIds;
+	FGitSourceControlModule::GetInstance().GetProvider().GetStateStore().GetLockIds(CachedLockIds);
+
+	for(const auto& Lock : InLocks)
+	{
+		const int32* CachedLockId = CachedLockIds.Find(Lock.Key);
+		if(CachedLockId == nullptr || *CachedLockId != Lock.Value.LockId)
 		{
-			ParseNameStatusResults(InPathToGitBinary, InRepositoryRoot, StdOut, States);
+			OutFiles.Add(Lock.Key);
 		}
-		else
+	}
+
+	for(const auto& CachedLock : CachedLockIds)
+	{
+		if(!InLocks.Contains(CachedLock.Key))
+		{
+			OutFiles.Add(CachedLock.Key);
+		}
+	}
+}
+
+bool RunFetch(const FGitSourceControlCommand& InCommand)
+{
+	FGitFetchScheduler& FetchScheduler = FGitSourceControlModule::GetInstance().GetProvider().GetFetchScheduler();
+	const FString RemoteBranch = InCommand.Remote + "/" + InCommand.Branch;
+
+	//Note: fetches update refs/remotes and FETCH_HEAD, they run one at a time even from commands reading the repository concurrently
+	const double WaitStartSeconds = FPlatformTime::Seconds();
+	FScopeLock FetchLock(&FetchScheduler.GetFetchCriticalSection());
+
+	//A fetch which completed while waiting is as recent as this one would be
+	bool bFetchedWhileWaiting = false;
+	if(FetchScheduler.WasFetchedSince(InCommand.PathToRepositoryRoot, WaitStartSeconds, bFetchedWhileWaiting))
+	{
+		GITCENTRAL_VERBOSE(TEXT("Fetch: %s was fetched while waiting, skipping fetch"), *RemoteBranch);
+		return bFetchedWhileWaiting;
+	}
+
+	//Probe the remote first, a fetch negotiates with the remote even when there is nothing new
+	FString ProbedSha;
+	if(!RunRemoteProbe(InCommand, ProbedSha))
+	{
+		//Note: the remote cannot be reached, a fetch would only wait for the same network error
+		FetchScheduler.RecordFetch(InCommand.PathToRepositoryRoot, false, FString(), false);
+		return false;
+	}
+
+	if(!ProbedSha.IsEmpty() && ProbedSha == GetCommitShaForBranch(RemoteBranch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot))
+	{
+		GITCENTRAL_VERBOSE(TEXT("Fetch: %s is already at %s, skipping fetch"), *RemoteBranch, *ProbedSha);
+		FetchScheduler.RecordFetch(InCommand.PathToRepositoryRoot, true, ProbedSha, !IsAncestor(ProbedSha, InCommand.Branch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot));
+		return true;
+	}
+
+	TArray<FString> StdOut;
+	TArray<FString> StdErr;
+
+	TArray<FString> Parameters;
+	Parameters.Add("--quiet");
+	Parameters.Add(InCommand.Remote);
+	Parameters.Add(InCommand.Branch);
+
+	const bool bResult = GitSourceControlUtils::RunCommand(TEXT("fetch"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
+	FString RemoteSha;
+	bool bUpdatesAvailable = false;
+	if(bResult)
+	{
+		UpdateCommitGraph(InCommand);
+		RemoteSha = GetCommitShaForBranch(RemoteBranch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+		bUpdatesAvailable = !RemoteSha.IsEmpty() && !IsAncestor(RemoteSha, InCommand.Branch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+	}
+	FetchScheduler.RecordFetch(InCommand.PathToRepositoryRoot, bResult, RemoteSha, bUpdatesAvailable);
+	return bResult;
+}
+
+bool RunRemoteProbe(const FGitSourceControlCommand& InCommand, FString& OutRemoteSha)
+{
+	TArray<FString> StdOut;
+	TArray<FString> StdErr;
+
+	const FString BranchRef = TEXT("refs/heads/") + InCommand.Branch;
+	TArray<FString> Parameters;
+	Parameters.Add(InCommand.Remote);
+	Parameters.Add(BranchRef);
+
+	OutRemoteSha.Empty();
+	const bool bResult = GitSourceControlUtils::RunCommand(TEXT("ls-remote"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
+	if(bResult)
+	{
+		//Each line is "<sha>\t<ref>", the pattern may also match refs ending with the same path
+		for(const FString& Line : StdOut)
+		{
+			FString Sha;
+			FString Ref;
+			if(Line.Split(TEXT("\t"), &Sha, &Ref) && Ref == BranchRef)
+			{
+				OutRemoteSha = Sha;
+				break;
+			}
+		}
+	}
+	return bResult;
+}
+
+void UpdateCommitGraph(const FGitSourceControlCommand& InCommand)
+{
+	TArray<FString> Commits;
+	for(const FString& Branch : { InCommand.Branch, FString(InCommand.Remote + TEXT("/") + InCommand.Branch) })
+	{
+		const FString Sha = GetCommitShaForBranch(Branch, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+		if(!Sha.IsEmpty())
+		{
+			Commits.Add(Sha);
+		}
+	}
+
+	FGitSourceControlModule::GetInstance().GetProvider().GetCommitGraph().AddCommits(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Commits);
+}
+
+FString GetGitDirectory(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	TArray<FString> StdOut;
+	TArray<FString> StdErr;
+	if(!RunCommand(TEXT("rev-parse --git-dir"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, StdErr) || StdOut.Num() == 0)
+	{
+		return FString();
+	}
+
+	FString GitDir = StdOut[0];
+	if(FPaths::IsRelative(GitDir))
+	{
+		GitDir = FPaths::Combine(InRepositoryRoot, GitDir);
+	}
+	return GitDir;
+}
+
+bool ParseIndexHeader(const uint8* InData, int64 InSize, uint32& OutVersion, uint32& OutNumEntries)
+{
+	if(InSize < 12 || FMemory::Memcmp(InData, "DIRC", 4) != 0)
+	{
+		return false;
+	}
+
+	OutVersion = ReadUInt32BigEndian(InData + 4);
+	OutNumEntries = ReadUInt32BigEndian(InData + 8);
+	return true;
+}
+
+// Read the version from the header of the index file, without loading the entries
+static int32 ReadIndexVersion(const FString& InIndexFile)
+{
+	TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*InIndexFile));
+	uint8 Header[12];
+	uint32 Version = 0;
+	uint32 NumEntries = 0;
+	if(!FileHandle || !FileHandle->Read(Header, sizeof(Header)) || !ParseIndexHeader(Header, sizeof(Header), Version, NumEntries))
+	{
+		return 0;
+	}
+	return (int32)Version;
+}
+
+void RunRepositoryDoctor(FGitSourceControlCommand& InCommand)
+{
+	//Note: findings are reported as info, a slow repository must not prevent connecting
+	TArray<FString> StdOut;
+	TArray<FString> StdErr;
+
+	auto Report = [&InCommand](const FString& InMessage)
+	{
+		InCommand.InfoMessages.Add(TEXT("Repository check: ") + InMessage);
+	};
+
+	// Only explicitly set values are listed, keys are lower case
+	TMap<FString, FString> Config;
+	if(GitSourceControlUtils::RunCommand(TEXT("config --list"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, StdErr))
+	{
+		for(const FString& Line : StdOut)
 		{
-			return false;
+			FString Key;
+			FString Value;
+			if(Line.Split(TEXT("="), &Key, &Value))
+			{
+				// Last value wins, as for git
+				Config.Add(Key.ToLower(), Value);
+			}
 		}
 	}
 
-	// Run regular git status to update local status
+	auto GetConfigBool = [&Config](const TCHAR* InKey, bool bInDefault)
 	{
-		TArray<FString> Results;
-		TArray<FString> ErrorMessages;
-		TArray<FString> Parameters;
-		//If it's a dir update we must fetch the status of all untracked files (-u) otherwise status only returns the directory to be untracked
-		//Optimisation: Only run -u command with the directory parameters
-		if(bIsDirUpdate)
-			Parameters.Add(TEXT("-u"));
+		const FString* Value = Config.Find(InKey);
+		return Value ? FCString::ToBool(**Value) : bInDefault;
+	};
 
-		//We no longer get the status of ignored files
-		bool bResult = RunCommand(TEXT("status --porcelain"), InPathToGitBinary, InRepositoryRoot, Parameters, FilesParam, Results, ErrorMessages);
-		OutErrorMessages.Append(ErrorMessages);
-		if(bResult)
+	auto SetConfig = [&InCommand](const TCHAR* InKey, const TCHAR* InValue)
+	{
+		TArray<FString> ConfigStdOut;
+		TArray<FString> ConfigStdErr;
+		if(GitSourceControlUtils::RunCommand(TEXT("config"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, { InKey, InValue }, TArray<FString>(), ConfigStdOut, ConfigStdErr))
 		{
-			//Note: git status returns folders as well, when they are recently added and contain untracked files, with a not controlled status
-			// Using -u allows to see the untracked files instead of the folders, but folders will still appear 
-			TMap<FString, FGitSourceControlState> StatusStates;
-			ParseStatusResults(InPathToGitBinary, InRepositoryRoot, FilesParam, Results, StatusStates);
-
-			//Note: conflict here is not handled well, we assume normal operation will not generate local conflicts
-
-			//Local states are added and combined to regular statuses
-			for(auto& It : StatusStates)
-			{
-				FGitSourceControlState* StateResult = States.Find(It.Key);
-				if(StateResult)
-				{
-					//Combine local state with more recent status state
-					StateResult->CombineWithLocalState(It.Value);
-				}
-				else
-				{
-					States.Add(It.Key, It.Value);
-				}
-			}
+			InCommand.InfoMessages.Add(FString::Printf(TEXT("Repository configured: %s=%s"), InKey, InValue));
 		}
 		else
 		{
-			return false;
+			GITCENTRAL_ERROR(TEXT("Failed to set %s: %s"), InKey, *FString::Join(ConfigStdErr, TEXT("\n")));
 		}
-	}
+	};
 
-	//Note: we are not parsing the status file for deleted files if they haven't changed on the server or locally they are not relevant for the status update
-	//do not take into account checked out revision to create conflict on deletion because otherwise we can never submit the deletion!
+	const bool bAutoConfigure = InCommand.bAutoConfigureRepository;
 
-	// Get all the saved states before applying remote diffs
-	FGitSourceControlModule& GitSourceControl = FGitSourceControlModule::GetInstance();
-	FGitSourceControlStatusFile& StatusFile = GitSourceControl.GetStatusFile();
-	for(auto& It : States)
+	// feature.manyFiles (git 2.24) implies index.version=4 and core.untrackedCache=true
+	const bool bSupportsManyFiles = GitCapabilities::IsGitVersionAtLeast(2, 24);
+	bool bManyFiles = GetConfigBool(TEXT("feature.manyfiles"), false);
+	if(bManyFiles)
 	{
-		const FString& File = It.Value.GetFilename();
-		const auto& SavedState = StatusFile.GetState(File);
-		It.Value.CombineWithSavedState(SavedState, LocalBranchSha);
-
-		//Check on disk for accurate deleted state no matter what are the conditions
-		//Note: Fix for newly created assets, if something didn't have a status at all and doesn't exist on disk it's probably not deleted
-		if(It.Value.WorkingCopyState != EWorkingCopyState::Unknown)
-		{
-			//Note: git status returns folders as well, when they are recently added and contain untracked files, with a not controlled status
-			FFileStatData FileInfo = FPlatformFileManager::Get().GetPlatformFile().GetStatData(*File);
-			if (!FileInfo.bIsValid)//File or folder doesn't exist
-			{
-				It.Value.WorkingCopyState = EWorkingCopyState::Deleted;
-			}
-		}
+		Report(TEXT("feature.manyFiles is enabled"));
+	}
+	else if(bSupportsManyFiles && bAutoConfigure)
+	{
+		SetConfig(TEXT("feature.manyFiles"), TEXT("true"));
+		bManyFiles = true;
+	}
+	else
+	{
+		Report(TEXT("feature.manyFiles is not enabled, recommended for large repositories (git config feature.manyFiles true)"));
 	}
 
-	//Note: a file that has been added on remote, checked out locally, then deleted on remote will show as checked out instead of conflicted
-	//This is a rare case for now not handled, as it is equivalent to adding a new file again.
+	bool bUntrackedCache = GetConfigBool(TEXT("core.untrackedcache"), bManyFiles);
+	if(bUntrackedCache)
+	{
+		Report(TEXT("core.untrackedCache is enabled"));
+	}
+	else if(bAutoConfigure)
+	{
+		SetConfig(TEXT("core.untrackedCache"), TEXT("true"));
+		bUntrackedCache = true;
+	}
+	else
+	{
+		Report(TEXT("core.untrackedCache is disabled, status has to scan every directory for untracked files (git config core.untrackedCache true)"));
+	}
 
-	//Process remote states
-	if(RemoteStates.Num())
+	// Enabled by default since git 2.1
+	if(GetConfigBool(TEXT("core.preloadindex"), true))
 	{
-		for(auto& It : RemoteStates)
-		{
-			FGitSourceControlState* StateResult = States.Find(It.Key);
-			if(!StateResult) //States have all been created in ParseStatusResults
-				continue;
+		Report(TEXT("core.preloadIndex is enabled"));
+	}
+	else if(bAutoConfigure)
+	{
+		SetConfig(TEXT("core.preloadIndex"), TEXT("true"));
+	}
+	else
+	{
+		Report(TEXT("core.preloadIndex is disabled, the index is checked on a single thread (git config core.preloadIndex true)"));
+	}
 
-			//Note: if OldState == Deleted, we should not care about checked-out revision and always accept the conflict
-			EWorkingCopyState::Type OldState = StateResult->WorkingCopyState;
-			//Combine local state with "more recent" remote state
-			StateResult->CombineWithRemoteState(It.Value);
+	// The builtin file system monitor is available from git 2.37 on Windows and Mac, a hook path can be configured on any platform
+	const FString* FsMonitor = Config.Find(TEXT("core.fsmonitor"));
+	const bool bSupportsBuiltinFsMonitor = (PLATFORM_WINDOWS || PLATFORM_MAC) && GitCapabilities::IsGitVersionAtLeast(2, 37);
+	if(FsMonitor && !FsMonitor->IsEmpty() && *FsMonitor != TEXT("false"))
+	{
+		Report(FString::Printf(TEXT("core.fsmonitor is set to '%s'"), **FsMonitor));
+	}
+	else if(bSupportsBuiltinFsMonitor && bAutoConfigure)
+	{
+		SetConfig(TEXT("core.fsmonitor"), TEXT("true"));
+	}
+	else if(bSupportsBuiltinFsMonitor)
+	{
+		Report(TEXT("core.fsmonitor is not set, status has to check every file of the working copy (git config core.fsmonitor true)"));
+	}
+	else
+	{
+		Report(TEXT("core.fsmonitor is not set, the builtin file system monitor requires git 2.37 on Windows or Mac"));
+	}
 
-			//Resolve outdated or conflict when applicable
-			if(!StateResult->IsCurrent() && StateResult->CheckedOutRevision != "0")
+	// The index and objects live in the git directory, which is not always <root>/.git (worktrees, submodules)
+	const FString GitDir = GetGitDirectory(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+	if(!GitDir.IsEmpty())
+	{
+		// Version 4 compresses paths, the index of a large project is about half the size
+		const int32 IndexVersion = ReadIndexVersion(FPaths::Combine(GitDir, TEXT("index")));
+		if(IndexVersion >= 4)
+		{
+			Report(FString::Printf(TEXT("index version %d"), IndexVersion));
+		}
+		else if(IndexVersion > 0 && bAutoConfigure)
+		{
+			StdOut.Reset();
+			if(GitSourceControlUtils::RunCommand(TEXT("update-index --index-version 4"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, StdErr))
 			{
-				if(StateResult->CheckedOutRevision == RemoteBranchSha)
-				{
-					StateResult->ResolveConflict(OldState);
-				}
-				else
-				{
-					TArray<FString> StdOut;
-					TArray<FString> StdErr;
-					//Get the latest revision at which the file was changed on remote
-					const bool bResult = RunCommand(TEXT("log --pretty=format:\"%H\" -1 "), InPathToGitBinary, InRepositoryRoot, { RemoteBranch }, { It.Key }, StdOut, StdErr);
-					if(bResult && StdOut.Num() == 1)
-					{
-						//Last changed revision must be an ancestor of CheckedOutReivision
-						const FString& LastChangedRev = StdOut[0];
-						if(GetMergeBase(LastChangedRev, StateResult->CheckedOutRevision, InPathToGitBinary, InRepositoryRoot) == LastChangedRev)
-						{
-							StateResult->ResolveConflict(OldState);
-						}
-					}
-				}
+				InCommand.InfoMessages.Add(FString::Printf(TEXT("Repository configured: index upgraded from version %d to 4"), IndexVersion));
 			}
 		}
-	}
-
-	//Process locks
-	if (InCommand.bUseLocking)
-	{
-		TArray<FString> Results;
-		TArray<FString> ErrorMessages;
-		bool bResult = RunCommand(TEXT("lfs locks -r"), InPathToGitBinary, InRepositoryRoot, { InCommand.Remote }, TArray<FString>(), Results, ErrorMessages);
-		OutErrorMessages.Append(ErrorMessages);
-		if (bResult)
+		else if(IndexVersion > 0)
 		{
-			TMap<FString, FGitSourceControlState> LockStates;
-			ParseLocksResults(InPathToGitBinary, InRepositoryRoot, Results, LockStates);
+			Report(FString::Printf(TEXT("index version %d, version 4 is smaller and faster to load (git update-index --index-version 4)"), IndexVersion));
+		}
 
-			//Combine Lock States
-			for (auto& It : LockStates) //All locks state are locked, no need to test it here
+		const bool bHasCommitGraph = FPaths::FileExists(FPaths::Combine(GitDir, TEXT("objects/info/commit-graph")))
+			|| FPaths::FileExists(FPaths::Combine(GitDir, TEXT("objects/info/commit-graphs/commit-graph-chain")));
+		if(bHasCommitGraph)
+		{
+			Report(TEXT("commit-graph is present"));
+		}
+		else if(bAutoConfigure && GitCapabilities::IsGitVersionAtLeast(2, 18))
+		{
+			StdOut.Reset();
+			if(GitSourceControlUtils::RunCommand(TEXT("commit-graph write --reachable"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, StdErr))
 			{
-				FGitSourceControlState* StateResult = States.Find(It.Key);
-				if (StateResult)
-				{
-					StateResult->CombineWithLockedState(It.Value);
-				}
+				InCommand.InfoMessages.Add(TEXT("Repository configured: commit-graph written"));
 			}
 		}
 		else
 		{
-			return false;
+			Report(TEXT("no commit-graph, history walks (merge-base, log) parse every commit (git commit-graph write --reachable)"));
 		}
 	}
 
-	//Generate value array to return
-	TArray<FGitSourceControlState> OutStatesIteration;
-	States.GenerateValueArray(OutStatesIteration);
-	OutStates.Append(OutStatesIteration);
-
-	return true;
-}
-
-bool RunFetch(const FGitSourceControlCommand& InCommand)
-{
-	TArray<FString> StdOut;
-	TArray<FString> StdErr;
-
-	TArray<FString> Parameters;
-	Parameters.Add("--quiet");
-	Parameters.Add(InCommand.Remote);
-	Parameters.Add(InCommand.Branch);
-
-	return GitSourceControlUtils::RunCommand(TEXT("fetch"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), StdOut, StdErr);
-}
-
-// Run a Git show command to dump the binary content of a revision into a file.
-bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, const FString& InCommit, const FString& InDumpFileName)
-{
-	//If the file is tracked by LFS, we must fetch the real object and not the placeholder file
-	bool bIsLFSTracked = false;
-
+	// Thresholds are the defaults of gc.auto and gc.autoPackLimit
+	StdOut.Reset();
+	if(GitSourceControlUtils::RunCommand(TEXT("count-objects -v"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StdOut, StdErr))
 	{
-		TArray<FString> StdOut;
-		TArray<FString> StdErr;
-		bool bSuccess = GitSourceControlUtils::RunCommand(TEXT("check-attr filter"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), { InFile }, StdOut, StdErr);
-		if(bSuccess && StdOut.Num() == 1 && StdOut[0].EndsWith(TEXT("lfs")))
+		int32 LooseObjects = 0;
+		int32 Packs = 0;
+		for(const FString& Line : StdOut)
 		{
-			bIsLFSTracked = true;
+			if(Line.StartsWith(TEXT("count: ")))
+			{
+				LooseObjects = FCString::Atoi(*Line + 7);
+			}
+			else if(Line.StartsWith(TEXT("packs: ")))
+			{
+				Packs = FCString::Atoi(*Line + 7);
+			}
 		}
+
+		const bool bNeedsMaintenance = LooseObjects > 6700 || Packs > 50;
+		Report(FString::Printf(TEXT("%d loose objects, %d packs%s"), LooseObjects, Packs, bNeedsMaintenance ? TEXT(", repacking is recommended (git gc)") : TEXT("")));
 	}
 
-	bool bResult = false;
+	for(const FString& Error : StdErr)
+	{
+		GITCENTRAL_VERBOSE(TEXT("Repository check: %s"), *Error);
+	}
+}
+
+// Run a Git show command to get the binary content of a revision, used when the cat-file process is not available
+static bool RunShowToArray(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InObjectName, TArray<uint8>& OutContent)
+{
 	FString FullCommand;
 
 	if(!InRepositoryRoot.IsEmpty())
@@ -1174,9 +2688,7 @@ bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepository
 	FullCommand += TEXT("show ");
 
 	// Append to the command the parameter
-	FullCommand += InCommit;
-	FullCommand += ":";
-	FullCommand += InFile;
+	FullCommand += InObjectName;
 
 	const bool bLaunchDetached = false;
 	const bool bLaunchHidden = true;
@@ -1187,80 +2699,161 @@ bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepository
 
 	verify(FPlatformProcess::CreatePipe(PipeRead, PipeWrite));
 
+	FGitScopedCommandTrace Trace(TEXT("show"), 1);
+	const double Timeout = GetCommandTimeout(TEXT("show"));
+	const double StartTime = FPlatformTime::Seconds();
+
+	bool bResult = false;
+	bool bTerminated = false;
 	FProcHandle ProcessHandle = FPlatformProcess::CreateProc(*InPathToGitBinary, *FullCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, nullptr, PipeWrite);
 	if(ProcessHandle.IsValid())
 	{
 		FPlatformProcess::Sleep(0.01);
 
-		TArray<uint8> BinaryFileContent;
+		while(FPlatformProcess::IsProcRunning(ProcessHandle))
 		{
-			while(FPlatformProcess::IsProcRunning(ProcessHandle))
+			if(IsCurrentCommandCancelled())
 			{
-				TArray<uint8> BinaryData;
-				FPlatformProcess::ReadPipeToArray(PipeRead, BinaryData);
-				if(BinaryData.Num() > 0)
-				{
-					BinaryFileContent.Append(MoveTemp(BinaryData));
-				}
+				FPlatformProcess::TerminateProc(ProcessHandle, true);
+				bTerminated = true;
+				break;
+			}
+			if(Timeout > 0.0 && FPlatformTime::Seconds() - StartTime > Timeout)
+			{
+				GITCENTRAL_ERROR(TEXT("%s"), *MakeTimeoutError(TEXT("show"), Timeout));
+				FPlatformProcess::TerminateProc(ProcessHandle, true);
+				Trace.SetTimedOut();
+				bTerminated = true;
+				break;
 			}
 
 			TArray<uint8> BinaryData;
 			FPlatformProcess::ReadPipeToArray(PipeRead, BinaryData);
 			if(BinaryData.Num() > 0)
 			{
-				BinaryFileContent.Append(MoveTemp(BinaryData));
+				OutContent.Append(MoveTemp(BinaryData));
 			}
 		}
 
+		TArray<uint8> BinaryData;
+		FPlatformProcess::ReadPipeToArray(PipeRead, BinaryData);
+		if(BinaryData.Num() > 0)
+		{
+			OutContent.Append(MoveTemp(BinaryData));
+		}
+
+		//Note: a terminated process may report a successful exit code
 		int32 ReturnCode = -1;
 		FPlatformProcess::GetProcReturnCode(ProcessHandle, &ReturnCode);
+		if(bTerminated)
+		{
+			ReturnCode = -1;
+		}
 		bResult = ReturnCode == 0;
+		Trace.SetResult(OutContent.Num(), ReturnCode);
+	}
+
+	FPlatformProcess::ClosePipe(PipeRead, PipeWrite);
+	FPlatformProcess::CloseProc(ProcessHandle);
+
+	return bResult;
+}
+
+// Run a Git show command to dump the binary content of a revision into a file.
+bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, const FString& InCommit, const FString& InDumpFileName)
+{
+	//If the file is tracked by LFS, we must fetch the real object and not the placeholder file
+	bool bIsLFSTracked = false;
+
+	{
+		TArray<FString> StdOut;
+		TArray<FString> StdErr;
+		bool bSuccess = GitSourceControlUtils::RunCommand(TEXT("check-attr filter"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), { InFile }, StdOut, StdErr);
+		if(bSuccess && StdOut.Num() == 1 && StdOut[0].EndsWith(TEXT("lfs")))
+		{
+			bIsLFSTracked = true;
+		}
+	}
+
+	const bool bLaunchDetached = false;
+	const bool bLaunchHidden = true;
+	const bool bLaunchReallyHidden = bLaunchHidden;
+
+	const FString ObjectName = InCommit + TEXT(":") + InFile;
+	TArray<uint8> BinaryFileContent;
+	bool bResult = false;
 
-		//pipe through lfs smudge to get the real binary file
-		//Note: another approach is to use the "cat-file --filters" command, only available on newer than git 2.9.3
-		if(bResult && bIsLFSTracked)
+	// The blob is read from the persistent cat-file process, the show command is only a fallback
+	FGitCatFileBatch& CatFile = FGitSourceControlModule::GetInstance().GetProvider().GetCatFileBatch();
+	const EGitCatFileResult::Type CatFileResult = CatFile.GetObjectContent(InPathToGitBinary, InRepositoryRoot, ObjectName, BinaryFileContent);
+	if(CatFileResult == EGitCatFileResult::Found)
+	{
+		bResult = true;
+	}
+	else if(CatFileResult == EGitCatFileResult::Failed)
+	{
+		BinaryFileContent.Reset();
+		bResult = RunShowToArray(InPathToGitBinary, InRepositoryRoot, ObjectName, BinaryFileContent);
+	}
+
+	//pipe through lfs smudge to get the real binary file
+	//Note: another approach is to use the "cat-file --filters" command, only available on newer than git 2.9.3
+	if(bResult && bIsLFSTracked)
+	{
+		FString LfsSmudgeCommand;
+
+		if(!InRepositoryRoot.IsEmpty())
 		{
-			FString LfsSmudgeCommand;
+			LfsSmudgeCommand = TEXT("-C \"");
+			LfsSmudgeCommand += InRepositoryRoot;
+			LfsSmudgeCommand += TEXT("\" ");
+		}
 
-			if(!InRepositoryRoot.IsEmpty())
-			{
-				LfsSmudgeCommand = TEXT("-C \"");
-				LfsSmudgeCommand += InRepositoryRoot;
-				LfsSmudgeCommand += TEXT("\" ");
-			}
+		LfsSmudgeCommand += TEXT("lfs smudge");
 
-			LfsSmudgeCommand += TEXT("lfs smudge");
+		// For writing to child process
+		void* ReadPipeChild = nullptr;
+		void* WritePipeParent = nullptr;
+		verify(CreatePipeWrite(ReadPipeChild, WritePipeParent));
 
-			// For writing to child process
-			void* ReadPipeChild = nullptr;
-			void* WritePipeParent = nullptr;
-			verify(CreatePipeWrite(ReadPipeChild, WritePipeParent));
+		// For reading from child process
+		void* ReadPipeParent = nullptr;
+		void* WritePipeChild = nullptr;
+		verify(FPlatformProcess::CreatePipe(ReadPipeParent, WritePipeChild));
 
-			// For reading from child process
-			void* ReadPipeParent = nullptr;
-			void* WritePipeChild = nullptr;
-			verify(FPlatformProcess::CreatePipe(ReadPipeParent, WritePipeChild));
+		FString Written;
+		const FString LfsPointer = FString(BinaryFileContent.Num(), UTF8_TO_TCHAR(BinaryFileContent.GetData()));
 
-			FString Written;
-			const FString LfsPointer = FString(BinaryFileContent.Num(), UTF8_TO_TCHAR(BinaryFileContent.GetData()));
+		FGitScopedCommandTrace Trace(TEXT("lfs smudge"), 1);
+		const double Timeout = GetCommandTimeout(TEXT("lfs smudge"));
+		const double StartTime = FPlatformTime::Seconds();
 
-			FProcHandle LFSProcessHandle = FPlatformProcess::CreateProc(*InPathToGitBinary, *LfsSmudgeCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, nullptr, WritePipeChild, ReadPipeChild);
-			if(LFSProcessHandle.IsValid())
-			{
-				FPlatformProcess::Sleep(0.01);
+		bResult = false;
+		bool bTerminated = false;
+		FProcHandle LFSProcessHandle = FPlatformProcess::CreateProc(*InPathToGitBinary, *LfsSmudgeCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, nullptr, WritePipeChild, ReadPipeChild);
+		if(LFSProcessHandle.IsValid())
+		{
+			FPlatformProcess::Sleep(0.01);
 
-				FPlatformProcess::WritePipe(WritePipeParent, LfsPointer, &Written);
+			FPlatformProcess::WritePipe(WritePipeParent, LfsPointer, &Written);
 
-				BinaryFileContent.Reset();
+			BinaryFileContent.Reset();
 
-				while(FPlatformProcess::IsProcRunning(LFSProcessHandle))
+			while(FPlatformProcess::IsProcRunning(LFSProcessHandle))
+			{
+				if(IsCurrentCommandCancelled())
 				{
-					TArray<uint8> BinaryData;
-					FPlatformProcess::ReadPipeToArray(ReadPipeParent, BinaryData);
-					if(BinaryData.Num() > 0)
-					{
-						BinaryFileContent.Append(MoveTemp(BinaryData));
-					}
+					FPlatformProcess::TerminateProc(LFSProcessHandle, true);
+					bTerminated = true;
+					break;
+				}
+				if(Timeout > 0.0 && FPlatformTime::Seconds() - StartTime > Timeout)
+				{
+					GITCENTRAL_ERROR(TEXT("%s"), *MakeTimeoutError(TEXT("lfs smudge"), Timeout));
+					FPlatformProcess::TerminateProc(LFSProcessHandle, true);
+					Trace.SetTimedOut();
+					bTerminated = true;
+					break;
 				}
 
 				TArray<uint8> BinaryData;
@@ -1271,39 +2864,47 @@ bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepository
 				}
 			}
 
+			TArray<uint8> BinaryData;
+			FPlatformProcess::ReadPipeToArray(ReadPipeParent, BinaryData);
+			if(BinaryData.Num() > 0)
+			{
+				BinaryFileContent.Append(MoveTemp(BinaryData));
+			}
+
 			int32 LFSReturnCode = -1;
-			FPlatformProcess::GetProcReturnCode(ProcessHandle, &LFSReturnCode);
+			FPlatformProcess::GetProcReturnCode(LFSProcessHandle, &LFSReturnCode);
+			if(bTerminated)
+			{
+				LFSReturnCode = -1;
+			}
+			bResult = LFSReturnCode == 0;
+			Trace.SetResult(BinaryFileContent.Num(), LFSReturnCode);
+		}
 
-			bResult = ReturnCode == 0;
+		FPlatformProcess::ClosePipe(ReadPipeParent, WritePipeChild);
+		FPlatformProcess::ClosePipe(ReadPipeChild, WritePipeParent);
+		FPlatformProcess::CloseProc(LFSProcessHandle);
+	}
 
-			FPlatformProcess::ClosePipe(ReadPipeParent, WritePipeChild);
-			FPlatformProcess::ClosePipe(ReadPipeChild, WritePipeParent);
-			FPlatformProcess::CloseProc(LFSProcessHandle);
+	// Save buffer into temp file
+	if(bResult)
+	{
+		if(FFileHelper::SaveArrayToFile(BinaryFileContent, *InDumpFileName))
+		{
+			GITCENTRAL_LOG(TEXT("Wrote '%s' (%do)"), *InDumpFileName, BinaryFileContent.Num());
 		}
-
-		// Save buffer into temp file
-		if(bResult)
+		else
 		{
-			if(FFileHelper::SaveArrayToFile(BinaryFileContent, *InDumpFileName))
-			{
-				GITCENTRAL_LOG(TEXT("Wrote '%s' (%do)"), *InDumpFileName, BinaryFileContent.Num());
-			}
-			else
-			{
-				GITCENTRAL_ERROR(TEXT("Could not write %s"), *InDumpFileName);
-				bResult = false;
-			}
+			GITCENTRAL_ERROR(TEXT("Could not write %s"), *InDumpFileName);
+			bResult = false;
 		}
 	}
-	
+
 	if(!bResult)
 	{
 		GITCENTRAL_ERROR(TEXT("Failed to get file revision: %s:%s"), *InFile, *InCommit);
 	}
 
-	FPlatformProcess::ClosePipe(PipeRead, PipeWrite);
-	FPlatformProcess::CloseProc(ProcessHandle);
-
 	return bResult;
 }
 
@@ -1596,6 +3197,7 @@ bool RunLockFiles(const FString& InPathToGitBinary, const FString& InRepositoryR
 		bResult &= RunCommand(TEXT("lfs lock -r"), InPathToGitBinary, InRepositoryRoot, { InRemote }, { RelativePath }, StdOut, OutErrorMessages);
 	}
 
+	FGitSourceControlModule::GetInstance().GetProvider().GetLockCache().Invalidate();
 	return bResult;
 }
 
@@ -1700,6 +3302,7 @@ bool RunUnlockFiles(const FString& InPathToGitBinary, const FString& InRepositor
 		}
 	}
 
+	FGitSourceControlModule::GetInstance().GetProvider().GetLockCache().Invalidate();
 	return !bErrors;
 }
 
@@ -1707,22 +3310,11 @@ bool UpdateCachedStates(const TArray<FGitSourceControlState>& InStates)
 {
 	FGitSourceControlModule& GitSourceControl = FGitSourceControlModule::GetInstance();
 	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
-	int NbStatesUpdated = 0;
-
-	for(const auto& InState : InStates)
-	{
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = Provider.GetStateInternal(InState.AbsoluteFilename);
-		if(State.Get() != InState)
-		{
-			auto History = MoveTemp(State->History);
-			*State = InState;
-			State->TimeStamp = FDateTime::Now();
-			State->History = MoveTemp(History);
-			NbStatesUpdated++;
-		}
-	}
+	TArray<FString> ChangedFiles;
+	Provider.GetStateStore().SetStates(InStates, ChangedFiles);
+	Provider.AddChangedFiles(ChangedFiles);
 
-	return (NbStatesUpdated > 0);
+	return (ChangedFiles.Num() > 0);
 }
 
 /**
@@ -1773,14 +3365,10 @@ void RemoveRedundantErrors(FGitSourceControlCommand& InCommand, const FString& I
 GitIndexState RunCheckIndexValid(FGitSourceControlCommand& InCommand)
 {
 	//Run git status and check for conflicts
-	TArray<FString> Results;
-	TArray<FString> ErrorMessages;
-	bool bResult = RunCommand(TEXT("status --porcelain"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), Results, InCommand.ErrorMessages);
+	TMap<FString, FGitSourceControlState> StatusStates;
+	bool bResult = RunStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), StatusStates, InCommand.ErrorMessages);
 	if(bResult)
 	{
-		TMap<FString, FGitSourceControlState> StatusStates;
-		ParseStatusResults(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), Results, StatusStates);
-
 		for(auto& It : StatusStates)
 		{
 			if(It.Value.IsConflicted())
@@ -1842,23 +3430,15 @@ void CleanupStatusFile(FGitSourceControlCommand& InCommand)
 			Files.Add(It.Key);
 		}
 
-		TArray<FString> StdOut;
 		TArray<FString> StdErr;
 		TArray<FString> Parameters;
 		Parameters.Add(MergeBase);
 		Parameters.Add(RemoteBranch);
-		Success = RunCommand(TEXT("diff --name-status"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, Files, StdOut, StdErr);
-		if(Success)
-		{
-			ParseNameStatusResults(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, StdOut, RemoteStates);
-		}
+		Success = RunNameStatusDiff(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, Files, RemoteStates, StdErr);
 	}
 
 	if(Success)
 	{
-		TArray<FString> StdOut;
-		TArray<FString> StdErr;
-
 		for(auto It : SavedStates)
 		{
 			bool bClearState = false;
@@ -1882,8 +3462,7 @@ void CleanupStatusFile(FGitSourceControlCommand& InCommand)
 
 				if(!bClearState)
 				{
-					bClearState = RunCommand(TEXT("merge-base --is-ancestor"),
-						InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, { It.Value.CheckedOutRevision, MergeBase }, TArray<FString>(), StdOut, StdErr);
+					bClearState = IsAncestor(It.Value.CheckedOutRevision, MergeBase, InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
 				}
 			}
 
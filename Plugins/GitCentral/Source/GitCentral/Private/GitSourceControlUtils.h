@@ -2,8 +2,11 @@
 
 #pragma once
 
+#include "Containers/StringView.h"
+#include "Templates/Function.h"
 #include "GitSourceControlState.h"
 #include "GitSourceControlRevision.h"
+#include "GitSourceControlRemoteDiffCache.h"
 
 class FGitSourceControlCommand;
 
@@ -99,6 +102,8 @@ void GetRemoteNames(const FString& InPathToGitBinary, const FString& InRepositor
 
 /**
  * Run a Git command - output is a string TArray.
+ * Many files are passed on stdin with --pathspec-from-file when git and the command support it (add, checkout, commit, reset, restore, rm, stash push),
+ * otherwise the command is run by batches.
  *
  * @param	InCommand			The Git command - e.g. commit
  * @param	InPathToGitBinary	The path to the Git binary
@@ -112,7 +117,22 @@ void GetRemoteNames(const FString& InPathToGitBinary, const FString& InRepositor
 bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
 
 /**
- * Run a Git "commit" command by batches.
+ * Run a Git command - output is passed line by line to a callback while the command is running, instead of being buffered.
+ * Empty lines are skipped and line terminators are removed.
+ *
+ * @param	InCommand			The Git command - e.g. status
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
+ * @param	InParameters		The parameters to the Git command
+ * @param	InFiles				The files to be operated on
+ * @param	InOnLine			Called for each line of StdOut, the view is only valid during the call
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the command succeeded and returned no errors
+ */
+bool RunCommandStreamed(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TFunctionRef<void(FStringView)> InOnLine, TArray<FString>& OutErrorMessages);
+
+/**
+ * Run a Git "commit" command, by batches amending the first commit if the files cannot be passed on stdin.
  *
  * @param	InPathToGitBinary	The path to the Git binary
  * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
@@ -130,13 +150,56 @@ bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot
  * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
  * @param	InFiles				The files to be operated on
  * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @param	InLocks				Locks already queried by the caller with RunGetLocks, queried again if null
  * @returns true if the command succeeded and returned no errors
  */
-bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates);
+bool RunUpdateStatus(FGitSourceControlCommand& InCommand, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates, FGitStateMapPtr InLocks = nullptr);
 
-//Internals
-void ParseStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, const TArray<FString>& InResults, TMap<FString, FGitSourceControlState>& OutStates);
-void ParseNameStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InResults, TMap<FString, FGitSourceControlState>& OutStates);
+/**
+ * Run a Git "lfs locks" command for all the locks of the remote and parse it
+ *
+ * @param	InCommand			The source control command (which contains all necessary parameters)
+ * @param	OutLocks			The lock owner and id of every locked file, keyed by absolute filename
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the command succeeded and returned no errors
+ */
+bool RunGetLocks(const FGitSourceControlCommand& InCommand, FGitStateMapPtr& OutLocks, TArray<FString>& OutErrorMessages);
+
+/**
+ * Find the cached files whose lock changed: locked, unlocked or locked again since their state was cached.
+ * Their whole state must be refreshed, a lock changes how the local and remote states combine.
+ *
+ * @param	InLocks				All the locks of the remote, from RunGetLocks
+ * @param	OutFiles			Appended with the files whose lock changed
+ */
+void GetFilesWithChangedLocks(const FGitStateMap& InLocks, TArray<FString>& OutFiles);
+
+/**
+ * Run a Git "status" command and parse it. Uses "status --porcelain=v2 -z" when git supports it, which handles any path.
+ * Only files reported by git get a state, unchanged files are not reported.
+ *
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
+ * @param	InParameters		The additional parameters to the Git status command
+ * @param	InFiles				The files to be operated on, or empty for the whole repository
+ * @param	OutStates			The states of the reported files, keyed by absolute filename
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the command succeeded and returned no errors
+ */
+bool RunStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TMap<FString, FGitSourceControlState>& OutStates, TArray<FString>& OutErrorMessages);
+
+/**
+ * Run a Git "diff --name-status -z" command and parse it.
+ *
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
+ * @param	InParameters		The commits to compare and additional parameters to the Git diff command
+ * @param	InFiles				The files to be operated on, or empty for the whole repository
+ * @param	OutStates			The states of the changed files, keyed by absolute filename
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the command succeeded and returned no errors
+ */
+bool RunNameStatusDiff(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TMap<FString, FGitSourceControlState>& OutStates, TArray<FString>& OutErrorMessages);
 
 
 /**
@@ -148,7 +211,26 @@ void ParseNameStatusResults(const FString& InPathToGitBinary, const FString& InR
 bool RunFetch(const FGitSourceControlCommand& InCommand);
 
 /**
- * Run a Git "show" command to dump the binary content of a revision into a file. Will use git lfs smudge if the file is tracked by git lfs.
+ * Ask the remote for the commit of the tracked branch with ls-remote, much cheaper than a fetch negotiation.
+ *
+ * @param	InCommand		The source control command (which contains all necessary parameters)
+ * @param	OutRemoteSha	The commit of the branch on the remote, empty if the remote does not have the branch
+ * @returns true if the remote could be reached
+ */
+bool RunRemoteProbe(const FGitSourceControlCommand& InCommand, FString& OutRemoteSha);
+
+/**
+ * Inspect the repository configuration that matters for large trees: feature.manyFiles, core.untrackedCache, core.preloadIndex,
+ * core.fsmonitor, index version, commit-graph and object counts. Findings are added to the info messages of the command.
+ * Recommended settings are applied when the command has bAutoConfigureRepository.
+ *
+ * @param	InCommand	The source control command (which contains all necessary parameters)
+ */
+void RunRepositoryDoctor(FGitSourceControlCommand& InCommand);
+
+/**
+ * Dump the binary content of a revision into a file. Will use git lfs smudge if the file is tracked by git lfs.
+ * The content is read from the persistent cat-file process, falling back to a Git "show" command.
  *
  * @param	InPathToGitBinary	The path to the Git binary
  * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
@@ -230,20 +312,74 @@ GitIndexState RunCheckIndexValid(FGitSourceControlCommand& InCommand);
 
 
 /**
- * Returns a full SHA identifier for a logical commit or branch name
+ * Returns a full SHA identifier for a logical commit or branch name, resolved by the persistent cat-file process when possible.
+ * Memoized for the duration of the command running on this thread, until it runs a command that may move refs.
  *
  * @param	InBranch	The branch or commit name
  * @returns FString		The SHA of this branch/commit
  */
 FString GetCommitShaForBranch(const FString& InBranch, const FString& InPathToGitBinary, const FString& InRepositoryRoot);
 
+/**
+ * Returns the git directory of the repository, where the index and objects live
+ * It is not always <root>/.git: linked worktrees and submodules have their own.
+ *
+ * @returns FString		The absolute path of the git directory, empty if it could not be resolved
+ */
+FString GetGitDirectory(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+/**
+ * Reads a 32 bits big endian integer, the byte order of the binary files of git (index, commit-graph)
+ */
+inline uint32 ReadUInt32BigEndian(const uint8* InData)
+{
+	return ((uint32)InData[0] << 24) | ((uint32)InData[1] << 16) | ((uint32)InData[2] << 8) | (uint32)InData[3];
+}
+
+/**
+ * Parses the header of an index file: "DIRC" signature, 32 bits version and number of entries
+ *
+ * @param	InData			The start of the index file
+ * @param	InSize			The number of bytes available
+ * @returns false if the data is not an index file, the version is not checked
+ */
+bool ParseIndexHeader(const uint8* InData, int64 InSize, uint32& OutVersion, uint32& OutNumEntries);
+
 /**
  * Returns the best common ancestor for a potential merge
+ * Answered from the commit index when possible, memoized for the duration of the command running on this thread, until it runs a command that may move refs.
  *
  * @returns FString		The SHA of the selected ancestor
  */
 FString GetMergeBase(const FString& InCommit1, const FString& InCommit2, const FString& InPathToGitBinary, const FString& InRepositoryRoot);
 
+/**
+ * Whether a commit is an ancestor of another one, or the same commit
+ * Memoized for the duration of the command running on this thread, until it runs a command that may move refs.
+ */
+bool IsAncestor(const FString& InAncestor, const FString& InCommit, const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+/**
+ * Add the commits of the local and remote branches to the commit index of the provider, after a command which created or fetched commits
+ * Merge-base and ancestry queries are answered from this index without running git whenever possible.
+ *
+ * @param	InCommand	The source control command (which contains all necessary parameters)
+ */
+void UpdateCommitGraph(const FGitSourceControlCommand& InCommand);
+
+/**
+ * Get the changes from the merge-base to the remote branch, as parsed from diff --name-status
+ * The diff is cached in the provider and reused until one of the commits moves, a remote commit moving forward only diffs the new commits.
+ *
+ * @param	InCommand			The source control command (which contains all necessary parameters)
+ * @param	InMergeBase			The SHA of the merge-base of the local and remote branches
+ * @param	InRemoteSha			The SHA of the remote branch
+ * @param	OutRemoteStates		The states of the changed files, keyed by absolute filename, shared with the cache
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the diff is available
+ */
+bool GetRemoteDiff(const FGitSourceControlCommand& InCommand, const FString& InMergeBase, const FString& InRemoteSha, FGitStateMapPtr& OutRemoteStates, TArray<FString>& OutErrorMessages);
+
 /**
  * Performs a cleanup of the status file by removing irrelevant or outdated entries
  */
@@ -2,6 +2,17 @@
 
 #pragma once
 
+/** Order in which the scheduler runs the queued commands */
+namespace EGitCommandPriority
+{
+	enum Type
+	{
+		Background, // Refreshes nobody waits for
+		Normal,
+		Interactive, // Operations the user waits for
+	};
+}
+
 class IGitSourceControlWorker
 {
 public:
@@ -22,6 +33,15 @@ public:
 	virtual bool UpdateStates() const = 0;
 
 	virtual bool IsConnected() const { return false; }
+
+	/**
+	 * Whether the work only reads the repository. Read-only commands run concurrently, the others run alone
+	 * so that they never collide on index.lock or on refs.
+	 */
+	virtual bool IsReadOnly() const { return false; }
+
+	/** Priority of the work in the scheduler queue, synchronous commands are always interactive */
+	virtual EGitCommandPriority::Type GetPriority() const { return EGitCommandPriority::Normal; }
 };
 
 typedef TSharedRef<IGitSourceControlWorker, ESPMode::ThreadSafe> FGitSourceControlWorkerRef;
\ No newline at end of file